@@ -0,0 +1,249 @@
+/*
+ * File:	Arena.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		arenas in Tiny C.
+ *
+ *		The first block of a pool is small and each block after it
+ *		is twice the size of the one before, up to a limit, so
+ *		that the arena of a small function stays small.  When a
+ *		pool is reset, its largest block is kept for reuse, so
+ *		that an arena reset after every function hardly ever needs
+ *		to allocate once it has grown large enough.  Pools and
+ *		blocks are allocated with the usual operator new so that
+ *		they can be counted like anything else.
+ */
+
+# include <cstdint>
+# include <cstring>
+# include "Arena.h"
+
+using namespace std;
+
+static const size_t smallest = 1024, largest = 64 * 1024;
+
+
+/*
+ * Function:	Arena::Pool::~Pool (destructor)
+ *
+ * Description:	Free every block of this pool.
+ */
+
+Arena::Pool::~Pool()
+{
+    Block *block;
+
+
+    while ((block = blocks) != nullptr) {
+	blocks = block->next;
+	::operator delete(block);
+    }
+}
+
+
+/*
+ * Function:	Arena::Pool::grow
+ *
+ * Description:	Start a new block that can hold at least the given number
+ *		of bytes.  Whatever is left of the current block is lost.
+ */
+
+void Arena::Pool::grow(size_t size)
+{
+    Block *block;
+    size_t total;
+
+
+    total = blocks == nullptr ? smallest : blocks->size * 2;
+
+    if (total > largest)
+	total = largest;
+
+    if (total < size + sizeof(Block))
+	total = size + sizeof(Block);
+
+    block = static_cast<Block *>(::operator new(total));
+    block->next = blocks;
+    block->size = total;
+
+    blocks = block;
+    next = reinterpret_cast<char *>(block + 1);
+    end = reinterpret_cast<char *>(block) + total;
+}
+
+
+/*
+ * Function:	Arena::Pool::allocate
+ *
+ * Description:	Allocate the given number of bytes with the given
+ *		alignment, which must be a power of two.
+ */
+
+void *Arena::Pool::allocate(size_t size, size_t align)
+{
+    uintptr_t start;
+
+
+    start = (reinterpret_cast<uintptr_t>(next) + align - 1) & -align;
+
+    if (next == nullptr || start + size > reinterpret_cast<uintptr_t>(end)) {
+	grow(size + align - 1);
+	start = (reinterpret_cast<uintptr_t>(next) + align - 1) & -align;
+    }
+
+    next = reinterpret_cast<char *>(start + size);
+    return reinterpret_cast<void *>(start);
+}
+
+
+/*
+ * Function:	Arena::Pool::reset
+ *
+ * Description:	Free everything allocated in this pool at once.  The
+ *		largest block is kept for whatever is allocated next.
+ */
+
+void Arena::Pool::reset()
+{
+    Block *block, *keep;
+
+
+    keep = nullptr;
+
+    while ((block = blocks) != nullptr) {
+	blocks = block->next;
+
+	if (keep == nullptr || block->size > keep->size) {
+	    if (keep != nullptr)
+		::operator delete(keep);
+
+	    keep = block;
+	} else
+	    ::operator delete(block);
+    }
+
+    next = end = nullptr;
+
+    if (keep != nullptr) {
+	keep->next = nullptr;
+	blocks = keep;
+	next = reinterpret_cast<char *>(keep + 1);
+	end = reinterpret_cast<char *>(keep) + keep->size;
+    }
+}
+
+
+/*
+ * Function:	Arena::Arena (constructor)
+ *
+ * Description:	Initialize this arena to be empty.  No memory is
+ *		allocated until something is allocated in it.
+ */
+
+Arena::Arena()
+    : _pool(nullptr)
+{
+}
+
+
+/*
+ * Function:	Arena::Arena (move constructor)
+ *
+ * Description:	Initialize this arena by taking over the pool of the
+ *		given arena, which is left empty.
+ */
+
+Arena::Arena(Arena &&other) noexcept
+    : _pool(other._pool)
+{
+    other._pool = nullptr;
+}
+
+
+/*
+ * Function:	Arena::operator = (move assignment)
+ *
+ * Description:	Free the pool of this arena and take over the pool of
+ *		the given arena, which is left empty.
+ */
+
+Arena &Arena::operator =(Arena &&other) noexcept
+{
+    if (this != &other) {
+	delete _pool;
+	_pool = other._pool;
+	other._pool = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * Function:	Arena::~Arena (destructor)
+ *
+ * Description:	Free the pool of this arena, if it has one.
+ */
+
+Arena::~Arena()
+{
+    delete _pool;
+}
+
+
+/*
+ * Function:	Arena::pool (private)
+ *
+ * Description:	Return the pool of this arena, creating it if need be.
+ */
+
+Arena::Pool *Arena::pool()
+{
+    if (_pool == nullptr)
+	_pool = new Pool();
+
+    return _pool;
+}
+
+
+/*
+ * Function:	Arena::allocate
+ *
+ * Description:	Allocate the given number of bytes with the given
+ *		alignment, which must be a power of two.
+ */
+
+void *Arena::allocate(size_t size, size_t align)
+{
+    return pool()->allocate(size, align);
+}
+
+
+/*
+ * Function:	Arena::copy
+ *
+ * Description:	Copy the given text into this arena and return the copy.
+ */
+
+string_view Arena::copy(string_view text)
+{
+    char *p;
+
+
+    p = static_cast<char *>(allocate(text.size(), 1));
+    memcpy(p, text.data(), text.size());
+    return string_view(p, text.size());
+}
+
+
+/*
+ * Function:	Arena::reset
+ *
+ * Description:	Free everything allocated in this arena at once.
+ */
+
+void Arena::reset()
+{
+    if (_pool != nullptr)
+	_pool->reset();
+}
@@ -0,0 +1,109 @@
+/*
+ * File:	Arena.h
+ *
+ * Description:	This file contains the class definitions for arenas in
+ *		Tiny C.  An arena hands out memory by moving a pointer
+ *		through large blocks, and frees it all at once when it is
+ *		reset or destroyed.  Nothing allocated in an arena is ever
+ *		destroyed by itself, so anything kept in an arena must keep
+ *		whatever it owns there as well, which a container does by
+ *		using an arena allocator.
+ *
+ *		The blocks belong to a pool, and an arena is only a handle
+ *		on its pool.  Moving an arena moves the pool, and an arena
+ *		allocator refers to the pool rather than the arena, so a
+ *		container keeps allocating from the same memory wherever
+ *		its arena goes.
+ *
+ *		Each compilation has an arena for its global declarations,
+ *		which lasts as long as the compilation does, and each
+ *		function has an arena for its scope, parameters, and
+ *		locals, which is reset once the function is written out.
+ */
+
+# ifndef ARENA_H
+# define ARENA_H
+# include <cstddef>
+# include <new>
+# include <string_view>
+
+class Arena {
+    template<class T> friend class ArenaAllocator;
+
+    struct Block {
+	Block *next;
+	size_t size;
+    };
+
+    struct Pool {
+	Block *blocks = nullptr;
+	char *next = nullptr, *end = nullptr;
+
+	~Pool();
+	void *allocate(size_t size, size_t align);
+	void grow(size_t size);
+	void reset();
+    };
+
+    Pool *_pool;
+
+    Pool *pool();
+
+public:
+    Arena();
+    Arena(Arena &&other) noexcept;
+    Arena &operator =(Arena &&other) noexcept;
+    ~Arena();
+
+    void *allocate(size_t size, size_t align = alignof(std::max_align_t));
+    std::string_view copy(std::string_view text);
+    void reset();
+};
+
+inline void *operator new(size_t size, Arena &arena)
+{
+    return arena.allocate(size);
+}
+
+inline void operator delete(void *, Arena &)
+{
+}
+
+template<class T>
+class ArenaAllocator {
+    template<class U> friend class ArenaAllocator;
+    Arena::Pool *_pool;
+
+public:
+    typedef T value_type;
+
+    ArenaAllocator() : _pool(nullptr) {}
+    ArenaAllocator(Arena &arena) : _pool(arena.pool()) {}
+
+    template<class U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : _pool(other._pool) {}
+
+    T *allocate(size_t n) {
+	if (_pool == nullptr)
+	    return static_cast<T *>(::operator new(n * sizeof(T)));
+
+	return static_cast<T *>(_pool->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, size_t) {
+	if (_pool == nullptr)
+	    ::operator delete(p);
+    }
+
+    template<class U>
+    bool operator ==(const ArenaAllocator<U> &other) const {
+	return _pool == other._pool;
+    }
+
+    template<class U>
+    bool operator !=(const ArenaAllocator<U> &other) const {
+	return _pool != other._pool;
+    }
+};
+
+# endif /* ARENA_H */
@@ -0,0 +1,142 @@
+/*
+ * File:	CompilationContext.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		compilation contexts in Tiny C.
+ */
+
+# include <cctype>
+# include <cerrno>
+# include <climits>
+# include <cstdlib>
+# include <thread>
+# include "CompilationContext.h"
+
+using namespace std;
+
+
+/*
+ * Function:	number
+ *
+ * Description:	Parse the given string as an unsigned decimal number.
+ *		Return whether it is one, with nothing else after it, and
+ *		fits in an unsigned.
+ */
+
+static bool number(const string &str, unsigned &value)
+{
+    unsigned long result;
+    char *end;
+
+
+    if (str.empty() || !isdigit((unsigned char) str[0]))
+	return false;
+
+    errno = 0;
+    result = strtoul(str.c_str(), &end, 10);
+
+    if (*end != '\0' || errno == ERANGE || result > UINT_MAX)
+	return false;
+
+    value = result;
+    return true;
+}
+
+
+/*
+ * Function:	Options::parse
+ *
+ * Description:	Set these options from the given command-line arguments,
+ *		adding anything that is not an option to the operands.
+ *		With -j N, N threads are used, and N of zero means one
+ *		thread for each processor.  With -ferror-limit=N, we give
+ *		up after N syntax errors and write no more than N
+ *		diagnostics, and N of zero means never.  Without it, we
+ *		give up at the first syntax error, but write every
+ *		diagnostic.  Return whether every option was recognized
+ *		and every number given to one is valid.
+ */
+
+bool Options::parse(const vector<string> &args, vector<string> &operands)
+{
+    size_t start, end;
+
+
+    for (size_t i = 0; i < args.size(); i ++) {
+	const string &arg = args[i];
+
+	if (arg == "-fpipeline")
+	    pipelined = true;
+	else if (arg == "-fshow-column")
+	    showcolumns = true;
+	else if (arg == "-flazy")
+	    lazy = true;
+	else if (arg == "-fimage")
+	    image = true;
+	else if (arg.compare(0, 9, "-fexport=") == 0) {
+	    lazy = true;
+
+	    for (start = 9; start < arg.size(); start = end + 1) {
+		if ((end = arg.find(',', start)) == string::npos)
+		    end = arg.size();
+
+		if (end > start)
+		    exports.push_back(arg.substr(start, end - start));
+	    }
+
+	} else if (arg.compare(0, 14, "-ferror-limit=") == 0) {
+	    if (!number(arg.substr(14), errorlimit))
+		return false;
+
+	    diagnosticlimit = errorlimit;
+
+	} else if (arg == "-fdiagnostics-format=json")
+	    json = true;
+	else if (arg == "-fdiagnostics-format=text")
+	    json = false;
+	else if (arg == "-fdiagnostics-dedup")
+	    dedup = true;
+
+	else if (arg.compare(0, 2, "-j") == 0) {
+	    if (arg.size() == 2 && i + 1 < args.size()) {
+		if (!number(args[++ i], threads))
+		    return false;
+
+	    } else if (!number(arg.substr(2), threads))
+		return false;
+
+	    if (threads == 0)
+		threads = thread::hardware_concurrency();
+
+	    if (threads == 0)
+		threads = 1;
+
+	} else if (arg.empty() || arg[0] != '-')
+	    operands.push_back(arg);
+	else
+	    return false;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:	CompilationContext::CompilationContext (constructor)
+ *
+ * Description:	Initialize this context to compile the given source with
+ *		the given options, writing output and diagnostics to the
+ *		given streams.  The global scope is created when parsing
+ *		begins.  Unless the whole compilation runs on one thread,
+ *		the identifiers, types, and literals are shared between
+ *		threads.
+ */
+
+CompilationContext::CompilationContext(const Source &source,
+	const Options &options, ostream &output, ostream &errors)
+    : source(source), options(options), output(output), errors(errors),
+      globals(nullptr), atoms(options.pipelined || options.threads > 0),
+      types(options.threads > 0), literals(atoms, types, options.threads > 0),
+      numerrors(0)
+{
+}
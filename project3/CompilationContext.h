@@ -0,0 +1,68 @@
+/*
+ * File:	CompilationContext.h
+ *
+ * Description:	This file contains the class definitions for compilation
+ *		contexts in Tiny C.  A compilation context holds everything
+ *		that belongs to the compilation of one source file: the
+ *		options, the streams that output and diagnostics are
+ *		written to, the arena and scope for global declarations,
+ *		the identifiers, the types, the literals, and the count
+ *		of errors.  Nothing about a
+ *		compilation is kept anywhere else, so any number of
+ *		independent compilations may run at once, each on its own
+ *		thread, and everything is freed along with the context.
+ *
+ *		A compilation may itself use several threads, so the
+ *		state of each thread, such as the current token and the
+ *		current scope, is kept by the parser running on it rather
+ *		than here.
+ */
+
+# ifndef COMPILATIONCONTEXT_H
+# define COMPILATIONCONTEXT_H
+# include <atomic>
+# include <ostream>
+# include <string>
+# include <vector>
+# include "Arena.h"
+# include "Scope.h"
+# include "Source.h"
+# include "atom.h"
+# include "literal.h"
+
+struct Options {
+    bool pipelined = false;
+    bool showcolumns = false;
+    bool lazy = false;
+    bool image = false;
+    bool json = false;
+    bool dedup = false;
+    unsigned threads = 0;
+    unsigned errorlimit = 1;
+    unsigned diagnosticlimit = 0;
+    std::vector<std::string> exports;
+
+    bool parse(const std::vector<std::string> &args,
+	std::vector<std::string> &operands);
+};
+
+struct CompilationContext {
+    const Source &source;
+    const Options &options;
+    std::ostream &output, &errors;
+
+    Arena arena;
+    Scope *globals;
+    Atoms atoms;
+    TypeTable types;
+    Literals literals;
+    std::atomic<int> numerrors;
+
+    CompilationContext(const Source &source, const Options &options,
+	std::ostream &output, std::ostream &errors);
+
+    CompilationContext(const CompilationContext &) = delete;
+    CompilationContext &operator =(const CompilationContext &) = delete;
+};
+
+# endif /* COMPILATIONCONTEXT_H */
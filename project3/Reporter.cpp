@@ -0,0 +1,402 @@
+/*
+ * File:	Reporter.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		reporters in Tiny C.
+ */
+
+# include <algorithm>
+# include "string.h"
+# include "tokens.h"
+# include "Reporter.h"
+
+using namespace std;
+
+
+/*
+ * Function:	Reporter::Reporter (constructor)
+ *
+ * Description:	Initialize this reporter to write diagnostics to the
+ *		diagnostic stream of the given compilation.
+ */
+
+Reporter::Reporter(CompilationContext &context)
+    : _context(context), _stream(&context.errors), _latest(0), _written(0),
+      _dropped(0)
+{
+}
+
+
+/*
+ * Function:	Reporter::Reporter (constructor)
+ *
+ * Description:	Initialize this reporter to write diagnostics for the
+ *		given compilation to the given stream.
+ */
+
+Reporter::Reporter(CompilationContext &context, ostream &stream)
+    : _context(context), _stream(&stream), _latest(0), _written(0),
+      _dropped(0)
+{
+}
+
+
+/*
+ * Function:	Reporter::stream
+ *
+ * Description:	Write diagnostics to the given stream from now on.  Any
+ *		diagnostics not yet written go to the old stream.
+ */
+
+void Reporter::stream(ostream &stream)
+{
+    flush();
+    _stream = &stream;
+}
+
+
+/*
+ * Function:	Reporter::sort (private)
+ *
+ * Description:	Sort the diagnostics kept so far by position.  Two
+ *		diagnostics at the same position keep the order in which
+ *		they were reported.
+ */
+
+void Reporter::sort()
+{
+    stable_sort(_pending.begin(), _pending.end(),
+	[](const Diagnostic &a, const Diagnostic &b) {
+	    return a.offset < b.offset;
+	});
+}
+
+
+/*
+ * Function:	Reporter::add (private)
+ *
+ * Description:	Keep the given message as a diagnostic at the given
+ *		offset, noting the record of it if it is to be reported
+ *		only once.  When no more than a limited number of
+ *		diagnostics may yet be written, we keep only that many,
+ *		the earliest in the source, so that a flood of errors
+ *		takes no more memory than the first few.
+ */
+
+void Reporter::add(size_t offset, const string &message, Kept *kept)
+{
+    unsigned limit = _context.options.diagnosticlimit;
+
+
+    _context.numerrors ++;
+
+    if (limit == 0 || _written + _pending.size() < limit) {
+	_pending.push_back({offset, message, kept});
+	_latest = max(_latest, offset);
+	return;
+    }
+
+    _dropped ++;
+
+    if (_pending.empty() || offset >= _latest)
+	return;
+
+    sort();
+    _pending.insert(upper_bound(_pending.begin(), _pending.end(), offset,
+	[](size_t offset, const Diagnostic &diagnostic) {
+	    return offset < diagnostic.offset;
+	}), {offset, message, kept});
+
+    _pending.pop_back();
+    _latest = _pending.back().offset;
+}
+
+
+/*
+ * Function:	Reporter::add (private)
+ *
+ * Description:	Keep the given message with the given key as above,
+ *		unless one with the same key has already been kept, in
+ *		which case it only counts as an error.  Diagnostics are
+ *		not always reported in order, so if this one comes earlier
+ *		in the source than the one kept, and that one is still
+ *		pending, we simply move it here, since the message is the
+ *		same.  If that one was dropped instead, this one is kept
+ *		in its place, and the drop no longer counts.
+ */
+
+void Reporter::add(size_t offset, const string &message, const Key &key)
+{
+    auto result = _seen.emplace(key, Kept{offset, false});
+    Kept &kept = result.first->second;
+
+
+    if (!result.second) {
+	if (kept.written || offset >= kept.offset) {
+	    _context.numerrors ++;
+	    return;
+	}
+
+	for (auto &diagnostic : _pending)
+	    if (diagnostic.kept == &kept) {
+		diagnostic.offset = kept.offset = offset;
+		_context.numerrors ++;
+		return;
+	    }
+
+	kept.offset = offset;
+	_dropped --;
+    }
+
+    add(offset, message, &kept);
+}
+
+
+/*
+ * Function:	Reporter::format (private)
+ *
+ * Description:	Return the given diagnostic as a line of text, prefixed
+ *		with its position, or as a line with a JSON object.  The
+ *		line and column are only computed here, when they are
+ *		actually needed.
+ */
+
+string Reporter::format(const Diagnostic &diagnostic) const
+{
+    unsigned line, column;
+    string result;
+
+
+    _context.source.locate(diagnostic.offset, line, column);
+
+    if (_context.options.json) {
+	result = "{\"line\":" + to_string(line);
+	result += ",\"column\":" + to_string(column);
+	result += ",\"severity\":\"error\",\"message\":";
+	result += quoteJSON(diagnostic.message) + "}\n";
+	return result;
+    }
+
+    result = "line " + to_string(line);
+
+    if (_context.options.showcolumns)
+	result += ", column " + to_string(column);
+
+    result += ": " + diagnostic.message + "\n";
+    return result;
+}
+
+
+/*
+ * Function:	Reporter::report
+ *
+ * Description:	Report an error at the current lexeme.  The message may
+ *		contain a %s, which is replaced with the given argument,
+ *		the name of a symbol if there is one.  We do the
+ *		replacement ourselves, so that a message of any length can
+ *		be reported.
+ */
+
+void Reporter::report(const string &str, string_view arg)
+{
+    string message = str;
+    size_t i;
+
+
+    if ((i = message.find("%s")) != string::npos)
+	message.replace(i, 2, arg);
+
+    add(_text.data() - _context.source.begin(), message);
+}
+
+
+/*
+ * Function:	Reporter::report
+ *
+ * Description:	Report an error at the current lexeme, with the name of
+ *		the given atom as its argument.  If asked, an error about
+ *		the same atom with the same format is reported only once,
+ *		though it still counts as an error each time.
+ */
+
+void Reporter::report(const string &str, Atom arg)
+{
+    string message = str;
+    size_t offset, i;
+
+
+    if ((i = message.find("%s")) != string::npos)
+	message.replace(i, 2, _context.atoms.name(arg));
+
+    offset = _text.data() - _context.source.begin();
+
+    if (_context.options.dedup)
+	add(offset, message, {str, arg});
+    else
+	add(offset, message);
+}
+
+
+/*
+ * Function:	Reporter::report
+ *
+ * Description:	Report an error as above, but at the given token, which
+ *		is normally the name the error is about, rather than at
+ *		the current lexeme, which by now may be well past it.
+ */
+
+void Reporter::report(const Token &token, const string &str, string_view arg)
+{
+    string message = str;
+    size_t i;
+
+
+    if ((i = message.find("%s")) != string::npos)
+	message.replace(i, 2, arg);
+
+    add(token.offset, message);
+}
+
+
+/*
+ * Function:	Reporter::report
+ *
+ * Description:	Report an error at the given token, with the name of the
+ *		given atom as its argument, and only once if asked, as
+ *		above.
+ */
+
+void Reporter::report(const Token &token, const string &str, Atom arg)
+{
+    string message = str;
+    size_t i;
+
+
+    if ((i = message.find("%s")) != string::npos)
+	message.replace(i, 2, _context.atoms.name(arg));
+
+    if (_context.options.dedup)
+	add(token.offset, message, {str, arg});
+    else
+	add(token.offset, message);
+}
+
+
+/*
+ * Function:	Reporter::report
+ *
+ * Description:	Report the lexical error noted in the given token, if
+ *		any, at the token.
+ */
+
+void Reporter::report(const Token &token)
+{
+    string kind = (token.kind == STRLIT ? "string" : "character");
+
+
+    if (token.error == LEX_TOO_LARGE)
+	add(token.offset, "integer constant too large");
+    else if (token.error == LEX_UNKNOWN_ESCAPE)
+	add(token.offset, "unknown escape sequence in " + kind + " constant");
+    else if (token.error == LEX_OUT_OF_RANGE)
+	add(token.offset,
+	    "escape sequence out of range in " + kind + " constant");
+    else if (token.error == LEX_MULTI_CHARACTER)
+	add(token.offset, "multi-character character constant");
+}
+
+
+/*
+ * Function:	Reporter::reportSyntax
+ *
+ * Description:	Report a syntax error at the current lexeme.
+ */
+
+void Reporter::reportSyntax()
+{
+    add(_text.data() - _context.source.begin(),
+	"syntax error at '" + string(_text) + "'");
+}
+
+
+/*
+ * Function:	Reporter::seen
+ *
+ * Description:	Return the keys of every message reported only once so
+ *		far.
+ */
+
+vector<Reporter::Key> Reporter::seen() const
+{
+    vector<Key> keys;
+
+
+    for (const auto &entry : _seen)
+	keys.push_back(entry.first);
+
+    return keys;
+}
+
+
+/*
+ * Function:	Reporter::flush
+ *
+ * Description:	Write out every diagnostic kept so far, in order of
+ *		position.  The diagnostics are gathered first and written
+ *		all at once.
+ */
+
+void Reporter::flush()
+{
+    unsigned limit = _context.options.diagnosticlimit;
+    string text;
+
+
+    sort();
+
+    for (const auto &diagnostic : _pending)
+	if (limit == 0 || _written < limit) {
+	    text += format(diagnostic);
+	    _written ++;
+
+	    if (diagnostic.kept != nullptr)
+		diagnostic.kept->written = true;
+
+	} else
+	    _dropped ++;
+
+    if (!text.empty())
+	*_stream << text;
+
+    _pending.clear();
+    _latest = 0;
+}
+
+
+/*
+ * Function:	Reporter::finish
+ *
+ * Description:	Write out every diagnostic kept so far, followed by a
+ *		note of how many were dropped, if any.
+ */
+
+void Reporter::finish()
+{
+    string message;
+
+
+    flush();
+
+    if (_dropped == 0)
+	return;
+
+    message = "too many errors, " + to_string(_dropped) + " not shown";
+
+    if (_context.options.json)
+	*_stream << "{\"severity\":\"note\",\"message\":" << quoteJSON(message)
+	    << "}\n";
+    else
+	*_stream << message << "\n";
+
+    _dropped = 0;
+}
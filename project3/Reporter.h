@@ -0,0 +1,95 @@
+/*
+ * File:	Reporter.h
+ *
+ * Description:	This file contains the class definition for reporters in
+ *		Tiny C.  A reporter writes diagnostics for one thread of a
+ *		compilation.  It keeps the current lexeme, which is where
+ *		a diagnostic is reported unless it is given the token it
+ *		is about, and the stream that diagnostics are written to,
+ *		which is normally that of the compilation but may be a
+ *		buffer instead.
+ *
+ *		Diagnostics are not written as they are reported, but kept
+ *		until the reporter is flushed, and then sorted by position
+ *		and written all at once.  The parser flushes only where
+ *		nothing it has yet to report can come earlier in the
+ *		source: at the start and end of each function body, or,
+ *		when bodies are parsed out of order, only at the end.  If
+ *		asked, a message about a symbol is reported only once in
+ *		the whole compilation, however many times it comes up,
+ *		and where it first comes up in the source.  It is known by
+ *		its format and the atom of the symbol, and we remember
+ *		where it was kept, and whether it was written, across
+ *		flushes.  With an
+ *		error limit, only that many diagnostics are written in
+ *		all, the earliest in the source, and those dropped are
+ *		counted in a note at the end.  Diagnostics are written
+ *		either as text or as JSON objects, one to a line.
+ */
+
+# ifndef REPORTER_H
+# define REPORTER_H
+# include <map>
+# include <ostream>
+# include <string>
+# include <string_view>
+# include <vector>
+# include "CompilationContext.h"
+# include "lexer.h"
+
+class Reporter {
+    typedef std::string string;
+    typedef std::string_view string_view;
+
+public:
+    typedef std::pair<string, Atom> Key;
+
+private:
+    struct Kept {
+	size_t offset;
+	bool written;
+    };
+
+    struct Diagnostic {
+	size_t offset;
+	string message;
+	Kept *kept;
+    };
+
+    CompilationContext &_context;
+    std::ostream *_stream;
+    string_view _text;
+    std::vector<Diagnostic> _pending;
+    std::map<Key, Kept> _seen;
+    size_t _latest;
+    unsigned _written, _dropped;
+
+    void sort();
+    void add(size_t offset, const string &message, Kept *kept = nullptr);
+    void add(size_t offset, const string &message, const Key &key);
+    string format(const Diagnostic &diagnostic) const;
+
+public:
+    Reporter(CompilationContext &context);
+    Reporter(CompilationContext &context, std::ostream &stream);
+
+    CompilationContext &context() const { return _context; }
+    void stream(std::ostream &stream);
+
+    string_view text() const { return _text; }
+    void text(string_view text) { _text = text; }
+
+    void report(const string &str, string_view arg = "");
+    void report(const string &str, Atom arg);
+    void report(const Token &token, const string &str, string_view arg);
+    void report(const Token &token, const string &str, Atom arg);
+    void report(const Token &token);
+    void reportSyntax();
+
+    std::vector<Key> seen() const;
+
+    void flush();
+    void finish();
+};
+
+# endif /* REPORTER_H */
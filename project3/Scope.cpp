@@ -5,9 +5,8 @@
  *		scopes in Tiny C.
  *
  *		We didn't allocate the symbols we're given, so we don't
- *		deallocate them.  That's the rule.  You have to do that
- *		yourself.  Besides, it's possible that they're hanging
- *		around other places, like abstract syntax trees.
+ *		deallocate them.  That's the rule.  They live in an arena
+ *		along with the scope, and go away with it.
  */
 
 # include <cassert>
@@ -15,15 +14,19 @@
 
 using namespace std;
 
+static const size_t small = 8;
+
 
 /*
  * Function:	Scope::Scope (constructor)
  *
- * Description:	Initialize this scope object.
+ * Description:	Initialize this scope object, which is allocated in the
+ *		given arena.
  */
 
-Scope::Scope(Scope *enclosing)
-    : _enclosing(enclosing)
+Scope::Scope(Arena &arena, Scope *enclosing)
+    : _enclosing(enclosing), _symbols(arena), _index(arena),
+      _visible(SIZE_MAX)
 {
 }
 
@@ -52,6 +55,49 @@ const Symbols &Scope::symbols() const
 }
 
 
+/*
+ * Function:	Scope::slot (private)
+ *
+ * Description:	Return the slot in the index for the given name, which is
+ *		either its slot or the empty slot where it would go.  Atoms
+ *		are handed out in order, so the multiplier scatters them.
+ */
+
+size_t Scope::slot(Atom name) const
+{
+    unsigned mask = _index.size() - 1;
+    unsigned h = (name * 2654435761U) & mask;
+
+
+    while (_index[h].atom != 0 && _index[h].atom != name)
+	h = (h + 1) & mask;
+
+    return h;
+}
+
+
+/*
+ * Function:	Scope::rehash (private)
+ *
+ * Description:	Rebuild the index with room for twice as many symbols as
+ *		there are now.
+ */
+
+void Scope::rehash()
+{
+    size_t size = 16;
+
+
+    while (size < 4 * _symbols.size())
+	size *= 2;
+
+    _index = Entries(size, Entry{0, 0}, _index.get_allocator());
+
+    for (size_t i = 0; i < _symbols.size(); i ++)
+	_index[slot(_symbols[i]->atom())] = {_symbols[i]->atom(), (uint32_t) i};
+}
+
+
 /*
  * Function:	Scope::insert
  *
@@ -61,8 +107,31 @@ const Symbols &Scope::symbols() const
 
 void Scope::insert(Symbol *symbol)
 {
-    assert(find(symbol->name()) == nullptr);
+    assert(find(symbol->atom()) == nullptr);
     _symbols.push_back(symbol);
+
+    if (_symbols.size() <= small)
+	return;
+
+    if (2 * _symbols.size() > _index.size())
+	rehash();
+    else
+	_index[slot(symbol->atom())] = {symbol->atom(),
+	    (uint32_t) _symbols.size() - 1};
+}
+
+
+/*
+ * Function:	Scope::limit
+ *
+ * Description:	Limit this scope to seeing only the symbols that have
+ *		been declared so far in its enclosing scope.
+ */
+
+void Scope::limit()
+{
+    assert(_enclosing != nullptr);
+    _visible = _enclosing->_symbols.size();
 }
 
 
@@ -70,16 +139,29 @@ void Scope::insert(Symbol *symbol)
  * Function:	Scope::find
  *
  * Description:	Find and return the symbol with the given name in this
- *		scope.  If no such symbol is found, return a null pointer.
+ *		scope, considering only the first so many symbols.  If no
+ *		such symbol is found, return a null pointer.
  */
 
-Symbol *Scope::find(const string &name) const
+Symbol *Scope::find(Atom name, size_t visible) const
 {
-    for (auto sym : _symbols)
-	if (sym->name() == name)
-	    return sym;
+    const Entry *entry;
+
+
+    if (_index.empty()) {
+	for (size_t i = 0; i < _symbols.size() && i < visible; i ++)
+	    if (_symbols[i]->atom() == name)
+		return _symbols[i];
+
+	return nullptr;
+    }
+
+    entry = &_index[slot(name)];
+
+    if (entry->atom == 0 || entry->position >= visible)
+	return nullptr;
 
-    return nullptr;
+    return _symbols[entry->position];
 }
 
 
@@ -92,7 +174,7 @@ Symbol *Scope::find(const string &name) const
  *		null pointer.
  */
 
-Symbol *Scope::lookup(const string &name) const
+Symbol *Scope::lookup(Atom name) const
 {
     Symbol *symbol;
 
@@ -100,5 +182,5 @@ Symbol *Scope::lookup(const string &name) const
     if ((symbol = find(name)) != nullptr)
 	return symbol;
 
-    return _enclosing != nullptr ? _enclosing->find(name) : nullptr;
+    return _enclosing != nullptr ? _enclosing->find(name, _visible) : nullptr;
 }
@@ -5,32 +5,55 @@
  *		C.  Each scope contains a vector of symbols and a link to
  *		its enclosing scope.
  *
- *		We could have used a map instead of a vector, but we want
- *		to maintain declaration order and we expect the number of
- *		symbols to be small.
+ *		The vector keeps the symbols in declaration order.  Most
+ *		scopes are small and are simply searched, but once a scope
+ *		has more than a few symbols, we also keep an index from
+ *		the atom of each name to its position in the vector, so
+ *		that a scope with thousands of globals is still searched
+ *		in constant time.  The index is an open-addressing hash
+ *		table with linear probing that is never more than half
+ *		full.  The vector and the index are kept in the same arena
+ *		as the scope.
+ *
+ *		Normally, every symbol in the enclosing scope is visible.
+ *		A scope may instead be limited to seeing only the symbols
+ *		that had been declared in its enclosing scope when it was
+ *		limited, which lets a function body that is parsed later
+ *		see only the global declarations that precede it.
  */
 
 # ifndef SCOPE_H
 # define SCOPE_H
-# include <string>
+# include <cstdint>
 # include <vector>
 # include "Symbol.h"
 
 class Scope {
-    typedef std::string string;
+    struct Entry {
+	Atom atom;
+	uint32_t position;
+    };
+
+    typedef std::vector<Entry, ArenaAllocator<Entry>> Entries;
 
     Scope *_enclosing;
     Symbols _symbols;
+    Entries _index;
+    size_t _visible;
+
+    size_t slot(Atom name) const;
+    void rehash();
 
 public:
-    Scope(Scope *enclosing = nullptr);
+    Scope(Arena &arena, Scope *enclosing = nullptr);
 
     Scope *enclosing() const;
     const Symbols &symbols() const;
 
     void insert(Symbol *symbol);
-    Symbol *find(const string &name) const;
-    Symbol *lookup(const string &name) const;
+    void limit();
+    Symbol *find(Atom name, size_t visible = SIZE_MAX) const;
+    Symbol *lookup(Atom name) const;
 };
 
 # endif /* SCOPE_H */
@@ -0,0 +1,246 @@
+/*
+ * File:	Source.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		source files in Tiny C.
+ *
+ *		A mapping is private and read-only.  We never write into
+ *		the source, which is why lexemes are views rather than
+ *		null-terminated strings.
+ *
+ *		The line index is built only as far as the positions that
+ *		are located, which is normally only when a diagnostic is
+ *		emitted.  Rather than the start of every line, it holds
+ *		the number of lines before each block of the source, so
+ *		that it takes a thousandth of the size of the source, and
+ *		a line is found by counting the newlines within a single
+ *		block.  Function bodies may be parsed on several threads at
+ *		once, so the index is protected by a lock.
+ */
+
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include "Source.h"
+# include "simd.h"
+
+using namespace std;
+
+static const size_t blockSize = 4096, releaseSize = 1024 * 1024;
+
+
+/*
+ * Function:	Source::Source (constructor)
+ *
+ * Description:	Initialize this source as empty.
+ */
+
+Source::Source()
+    : _data(""), _size(0), _mapped(0), _released(0)
+{
+}
+
+
+/*
+ * Function:	Source::~Source (destructor)
+ *
+ * Description:	Unmap this source if it was mapped.
+ */
+
+Source::~Source()
+{
+    if (_mapped != 0)
+	munmap((void *) _data, _mapped);
+}
+
+
+/*
+ * Function:	Source::read (private)
+ *
+ * Description:	Read the remainder of the given file descriptor into our
+ *		own buffer.  The hint is the expected size, if known.  We
+ *		allocate one more byte than we expect so that we do not
+ *		grow the buffer just to discover the end of the file.
+ */
+
+void Source::read(int fd, size_t hint)
+{
+    size_t size;
+    ssize_t n;
+
+
+    _buffer.resize(hint > 0 ? hint + 1 : 65536);
+    size = 0;
+
+    while ((n = ::read(fd, &_buffer[size], _buffer.size() - size)) > 0)
+	if ((size += n) == _buffer.size())
+	    _buffer.resize(2 * size);
+
+    _buffer.resize(size);
+    _data = _buffer.data();
+    _size = size;
+}
+
+
+/*
+ * Function:	Source::open
+ *
+ * Description:	Open the named file and map it into memory.  If the file
+ *		cannot be mapped, because it is not a regular file for
+ *		example, then it is read instead.  Return whether the file
+ *		could be opened.
+ */
+
+bool Source::open(const char *path)
+{
+    struct stat st;
+    void *data;
+    int fd;
+
+
+    if ((fd = ::open(path, O_RDONLY)) < 0)
+	return false;
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+	data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	if (data != MAP_FAILED) {
+	    madvise(data, st.st_size, MADV_SEQUENTIAL);
+	    _data = (const char *) data;
+	    _size = _mapped = st.st_size;
+	    close(fd);
+	    return true;
+	}
+    }
+
+    open(fd);
+    close(fd);
+    return true;
+}
+
+
+/*
+ * Function:	Source::open
+ *
+ * Description:	Read the contents of the given file descriptor, which is
+ *		typically the standard input.
+ */
+
+void Source::open(int fd)
+{
+    struct stat st;
+
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+	read(fd, st.st_size);
+    else
+	read(fd, 0);
+}
+
+
+/*
+ * Function:	Source::open
+ *
+ * Description:	Take the given text as the contents of this source, such
+ *		as a source that was sent to us rather than named.
+ */
+
+void Source::open(string &&text)
+{
+    _buffer = move(text);
+    _data = _buffer.data();
+    _size = _buffer.size();
+}
+
+
+/*
+ * Function:	Source::text
+ *
+ * Description:	Return a view of the given range of this source.
+ */
+
+string_view Source::text(size_t offset, size_t length) const
+{
+    return string_view(_data + offset, length);
+}
+
+
+/*
+ * Function:	Source::index (private)
+ *
+ * Description:	Extend the line index to cover the given block.  The lock
+ *		must be held.
+ */
+
+void Source::index(size_t block) const
+{
+    const char *start;
+
+
+    if (_lines.empty())
+	_lines.push_back(0);
+
+    while (_lines.size() <= block) {
+	start = _data + (_lines.size() - 1) * blockSize;
+	_lines.push_back(_lines.back() + countNewlines(start, start + blockSize));
+    }
+}
+
+
+/*
+ * Function:	Source::locate
+ *
+ * Description:	Compute the line and column of the given offset, both
+ *		counting from one.  The column is counted in bytes.
+ */
+
+void Source::locate(size_t offset, unsigned &line, unsigned &column) const
+{
+    size_t block = offset / blockSize, start;
+
+
+    {
+	lock_guard<mutex> guard(_lock);
+
+	index(block);
+	line = _lines[block];
+    }
+
+    start = block * blockSize;
+    line += countNewlines(_data + start, _data + offset) + 1;
+
+    for (start = offset; start > 0 && _data[start - 1] != '\n'; start --)
+	continue;
+
+    column = offset - start + 1;
+}
+
+
+/*
+ * Function:	Source::release
+ *
+ * Description:	Release the pages of a mapped source before the given
+ *		offset, which we are done with.  We release the pages a
+ *		megabyte at a time, since each release is a system call.
+ *		The line index is first extended over the pages, so that
+ *		locating a diagnostic later never has to read them back
+ *		in.  Only the thread that is reading the source from start
+ *		to finish should release it.
+ */
+
+void Source::release(size_t offset) const
+{
+    size_t end = offset / releaseSize * releaseSize;
+
+
+    if (_mapped != 0 && end > _released) {
+	{
+	    lock_guard<mutex> guard(_lock);
+	    index(end / blockSize);
+	}
+
+	madvise((void *) (_data + _released), end - _released, MADV_DONTNEED);
+	_released = end;
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * File:	Source.h
+ *
+ * Description:	This file contains the class definition for source files
+ *		in Tiny C.  A source file is simply an immutable sequence
+ *		of bytes.  A named file is mapped into memory if possible,
+ *		so that its contents are never copied; otherwise, we read
+ *		the contents into a buffer of our own.
+ *
+ *		Lexemes are handed out as views into the source, so a
+ *		source must outlive every token taken from it.  Positions
+ *		are byte offsets, which are translated into a line and
+ *		column only on request.
+ *
+ *		Once the text before some offset will never be scanned
+ *		again, a mapped source may be told to release it, so that
+ *		the pages of a large file do not stay in memory after we
+ *		are done with them.  The text is still there if needed; it
+ *		is simply read from the file again.
+ */
+
+# ifndef SOURCE_H
+# define SOURCE_H
+# include <mutex>
+# include <string>
+# include <string_view>
+# include <vector>
+
+class Source {
+    typedef std::string string;
+    typedef std::string_view string_view;
+
+    const char *_data;
+    size_t _size, _mapped;
+    string _buffer;
+    mutable std::mutex _lock;
+    mutable std::vector<unsigned> _lines;
+    mutable size_t _released;
+
+    void read(int fd, size_t hint);
+    void index(size_t block) const;
+
+public:
+    Source();
+    ~Source();
+
+    Source(const Source &) = delete;
+    Source &operator =(const Source &) = delete;
+
+    bool open(const char *path);
+    void open(int fd);
+    void open(string &&text);
+
+    const char *begin() const { return _data; }
+    const char *end() const { return _data + _size; }
+    size_t size() const { return _size; }
+
+    string_view text(size_t offset, size_t length) const;
+    void locate(size_t offset, unsigned &line, unsigned &column) const;
+    void release(size_t offset) const;
+};
+
+# endif /* SOURCE_H */
@@ -15,24 +15,26 @@ using namespace std;
 /*
  * Function:	Symbol::Symbol (constructor)
  *
- * Description:	Initialize this symbol with the specified name and type.
+ * Description:	Initialize this symbol with the specified atom of its
+ *		name, type, kind, and value, which only an integer literal
+ *		has.
  */
 
-Symbol::Symbol(const string &name, const Type &type, int kind)
-    : _name(name), _type(type), _kind(kind)
+Symbol::Symbol(Atom atom, const Type &type, int kind, int value)
+    : _atom(atom), _type(type), _kind(kind), _value(value)
 {
 }
 
 
 /*
- * Function:	Symbol::name (accessor)
+ * Function:	Symbol::atom (accessor)
  *
- * Description:	Return the name of this symbol.
+ * Description:	Return the atom of the name of this symbol.
  */
 
-const string &Symbol::name() const
+Atom Symbol::atom() const
 {
-    return _name;
+    return _atom;
 }
 
 
@@ -48,6 +50,18 @@ const Type &Symbol::type() const
 }
 
 
+/*
+ * Function:	Symbol::type (mutator)
+ *
+ * Description:	Update the type of this symbol.
+ */
+
+void Symbol::type(const Type &type)
+{
+    _type = type;
+}
+
+
 /*
  * Function:	Symbol::kind (accessor)
  *
@@ -70,3 +84,16 @@ void Symbol::kind(int k)
 {
     _kind = k;
 }
+
+
+/*
+ * Function:	Symbol::value (accessor)
+ *
+ * Description:	Return the value of this symbol, if it is an integer
+ *		literal, and zero otherwise.
+ */
+
+int Symbol::value() const
+{
+    return _value;
+}
@@ -3,30 +3,37 @@
  *
  * Description:	This file contains the class definition for symbols in Tiny
  *		C.  A symbol consists of a name and a type, along with an
- *		indicator of its kind (local, global, literal, etc.).
+ *		indicator of its kind (local, global, literal, etc.).  The
+ *		name is kept only as its atom, by which the symbol is
+ *		looked up, and the name itself is in the table of atoms.
+ *		Literals have atoms too, though they are never looked up,
+ *		and an integer literal also keeps its value.
  */
 
 # ifndef SYMBOL_H
 # define SYMBOL_H
-# include <string>
 # include <vector>
+# include "Arena.h"
+# include "atom.h"
 # include "tokens.h"
 # include "Type.h"
 
-typedef std::vector<class Symbol *> Symbols;
+typedef std::vector<class Symbol *, ArenaAllocator<class Symbol *>> Symbols;
 
 class Symbol {
-    typedef std::string string;
-    string _name;
+    Atom _atom;
     Type _type;
     int _kind;
+    int _value;
 
 public:
-    Symbol(const string &name, const Type &type, int kind);
-    const string &name() const;
+    Symbol(Atom atom, const Type &type, int kind, int value = 0);
+    Atom atom() const;
     const Type &type() const;
+    void type(const Type &type);
     int kind() const;
     void kind(int k);
+    int value() const;
 };
 
 # endif /* SYMBOL_H */
@@ -0,0 +1,211 @@
+/*
+ * File:	ThreadPool.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		thread pools in Tiny C.
+ *
+ *		Each queue has its own lock, which is held only long
+ *		enough to push or pop a task.  The pool lock protects the
+ *		counts of queued and pending tasks, and is used to sleep
+ *		when there is nothing to take.  A task is pending from
+ *		the time it is submitted until it has finished running.
+ *		The pool lock also guards the turn of the next queue and
+ *		the first exception thrown by a task.
+ */
+
+# include "ThreadPool.h"
+
+using namespace std;
+
+
+/*
+ * Function:	ThreadPool::ThreadPool (constructor)
+ *
+ * Description:	Initialize this pool and start the given number of
+ *		worker threads, which must be at least one.
+ */
+
+ThreadPool::ThreadPool(unsigned threads)
+    : _next(0), _queued(0), _pending(0), _stop(false)
+{
+    for (unsigned i = 0; i < threads; i ++)
+	_queues.emplace_back(new Queue);
+
+    for (unsigned i = 0; i < threads; i ++)
+	_workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+
+/*
+ * Function:	ThreadPool::~ThreadPool (destructor)
+ *
+ * Description:	Wait for any remaining tasks and stop the workers.  An
+ *		exception kept from a task that was never waited for is
+ *		dropped, since a destructor cannot throw.
+ */
+
+ThreadPool::~ThreadPool()
+{
+    finish();
+
+    {
+	lock_guard<mutex> guard(_lock);
+	_stop = true;
+    }
+
+    _ready.notify_all();
+
+    for (auto &worker : _workers)
+	worker.join();
+}
+
+
+/*
+ * Function:	ThreadPool::submit
+ *
+ * Description:	Add a task to the next queue in turn and wake a worker.
+ *		The turn is taken under the lock, so that tasks may be
+ *		submitted from any thread.
+ */
+
+void ThreadPool::submit(Task task)
+{
+    Queue *queue;
+
+
+    {
+	lock_guard<mutex> guard(_lock);
+	queue = _queues[_next ++ % _queues.size()].get();
+	_queued ++;
+	_pending ++;
+    }
+
+    {
+	lock_guard<mutex> guard(queue->lock);
+	queue->tasks.push_back(move(task));
+    }
+
+    _ready.notify_one();
+}
+
+
+/*
+ * Function:	ThreadPool::take (private)
+ *
+ * Description:	Take a task for the given worker, first from the back of
+ *		its own queue and then from the front of the others.
+ *		Return whether a task was found.
+ */
+
+bool ThreadPool::take(unsigned self, Task &task)
+{
+    unsigned n = _queues.size();
+
+
+    for (unsigned i = 0; i < n; i ++) {
+	Queue &queue = *_queues[(self + i) % n];
+	lock_guard<mutex> guard(queue.lock);
+
+	if (!queue.tasks.empty()) {
+	    if (i == 0) {
+		task = move(queue.tasks.back());
+		queue.tasks.pop_back();
+	    } else {
+		task = move(queue.tasks.front());
+		queue.tasks.pop_front();
+	    }
+
+	    return true;
+	}
+    }
+
+    return false;
+}
+
+
+/*
+ * Function:	ThreadPool::work (private)
+ *
+ * Description:	Run tasks until the pool is stopped.  This is the body of
+ *		each worker thread.  The first exception thrown by a task
+ *		is kept for wait() to rethrow.
+ */
+
+void ThreadPool::work(unsigned self)
+{
+    Task task;
+
+
+    while (1) {
+	if (take(self, task)) {
+	    {
+		lock_guard<mutex> guard(_lock);
+		_queued --;
+	    }
+
+	    try {
+		task();
+
+	    } catch (...) {
+		lock_guard<mutex> guard(_lock);
+
+		if (_error == nullptr)
+		    _error = current_exception();
+	    }
+
+	    lock_guard<mutex> guard(_lock);
+
+	    if (-- _pending == 0)
+		_finished.notify_all();
+
+	    continue;
+	}
+
+	unique_lock<mutex> guard(_lock);
+
+	if (_stop)
+	    return;
+
+	if (_queued == 0)
+	    _ready.wait(guard);
+    }
+}
+
+
+/*
+ * Function:	ThreadPool::finish (private)
+ *
+ * Description:	Wait until every task submitted so far has finished.
+ */
+
+void ThreadPool::finish()
+{
+    unique_lock<mutex> guard(_lock);
+
+    while (_pending > 0)
+	_finished.wait(guard);
+}
+
+
+/*
+ * Function:	ThreadPool::wait
+ *
+ * Description:	Wait until every task submitted so far has finished, and
+ *		then rethrow the first exception thrown by any of them.
+ */
+
+void ThreadPool::wait()
+{
+    exception_ptr error;
+
+
+    finish();
+
+    {
+	lock_guard<mutex> guard(_lock);
+	swap(error, _error);
+    }
+
+    if (error != nullptr)
+	rethrow_exception(error);
+}
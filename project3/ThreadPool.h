@@ -0,0 +1,64 @@
+/*
+ * File:	ThreadPool.h
+ *
+ * Description:	This file contains the class definition for thread pools
+ *		in Tiny C.  A thread pool runs independent tasks on a fixed
+ *		number of worker threads.
+ *
+ *		Each worker has its own queue of tasks.  Tasks are dealt
+ *		out to the queues in turn, and a worker takes tasks from
+ *		the back of its own queue.  A worker whose queue is empty
+ *		steals from the front of the queue of another worker, so
+ *		all of the workers stay busy even if the tasks differ
+ *		greatly in size.
+ *
+ *		An exception thrown by a task does not escape its worker.
+ *		The first one is kept instead and rethrown by wait(), so
+ *		it reaches whoever submitted the tasks.
+ */
+
+# ifndef THREADPOOL_H
+# define THREADPOOL_H
+# include <condition_variable>
+# include <deque>
+# include <exception>
+# include <functional>
+# include <memory>
+# include <mutex>
+# include <thread>
+# include <vector>
+
+class ThreadPool {
+    typedef std::function<void()> Task;
+
+    struct Queue {
+	std::mutex lock;
+	std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    unsigned _next;
+
+    std::mutex _lock;
+    std::condition_variable _ready, _finished;
+    unsigned long _queued, _pending;
+    std::exception_ptr _error;
+    bool _stop;
+
+    void work(unsigned self);
+    bool take(unsigned self, Task &task);
+    void finish();
+
+public:
+    ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator =(const ThreadPool &) = delete;
+
+    void submit(Task task);
+    void wait();
+};
+
+# endif /* THREADPOOL_H */
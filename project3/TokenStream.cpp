@@ -0,0 +1,234 @@
+/*
+ * File:	TokenStream.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		token streams in Tiny C.
+ *
+ *		The head and tail are positions in the stream rather than
+ *		in the ring, so they only ever increase.  The slot for a
+ *		position is found by masking, since the capacity is always
+ *		a power of two.  The producer never lets the tail get more
+ *		than the capacity ahead of the head.
+ *
+ *		Lexical errors and the current lexeme are handled when the
+ *		parser first looks at a token, not when the token is
+ *		scanned, so diagnostics come out in exactly the same order
+ *		whether or not we are pipelined.  A quiet stream does not
+ *		report lexical errors at all, which is useful when the
+ *		same text is scanned twice.
+ */
+
+# include <cassert>
+# include <climits>
+# include "tokens.h"
+# include "TokenStream.h"
+
+using namespace std;
+
+static const unsigned long small = 16, large = 1 << 15;
+
+
+/*
+ * Function:	TokenStream::TokenStream (constructor)
+ *
+ * Description:	Initialize this token stream to read from the source of
+ *		the given reporter, starting the lexer thread if we are
+ *		pipelined.  The reporter is kept up to date with the
+ *		current lexeme and is given any lexical errors.  Only a
+ *		pipelined stream needs a large ring, so that the lexer can
+ *		run well ahead; otherwise we scan each token only as the
+ *		parser asks for it, and a small ring will do.
+ */
+
+TokenStream::TokenStream(Reporter &reporter, bool pipelined)
+    : _source(reporter.context().source), _reporter(reporter),
+      _lexer(_source, reporter.context().atoms),
+      _ring(new Token[pipelined ? large : small]),
+      _capacity(pipelined ? large : small),
+      _pipelined(pipelined), _quiet(false), _stop(false), _head(0),
+      _available(0), _seen(0), _end(ULONG_MAX), _tail(0)
+{
+    if (_pipelined)
+	_thread = thread(&TokenStream::produce, this);
+}
+
+
+/*
+ * Function:	TokenStream::TokenStream (constructor)
+ *
+ * Description:	Initialize this token stream to read from the source of
+ *		the given reporter starting at the given offset.  Such a
+ *		stream is used to go back over text that has already been
+ *		skimmed, such as a function body, so it is never pipelined
+ *		and only needs a small ring.
+ */
+
+TokenStream::TokenStream(Reporter &reporter, size_t offset)
+    : _source(reporter.context().source), _reporter(reporter),
+      _lexer(_source, reporter.context().atoms, offset),
+      _ring(new Token[small]), _capacity(small),
+      _pipelined(false), _quiet(false), _stop(false), _head(0),
+      _available(0), _seen(0), _end(ULONG_MAX), _tail(0)
+{
+}
+
+
+/*
+ * Function:	TokenStream::~TokenStream (destructor)
+ *
+ * Description:	Stop the lexer thread if there is one, and deallocate
+ *		the ring.
+ */
+
+TokenStream::~TokenStream()
+{
+    if (_pipelined) {
+	_stop.store(true, memory_order_relaxed);
+	_thread.join();
+    }
+
+    delete[] _ring;
+}
+
+
+/*
+ * Function:	TokenStream::produce (private)
+ *
+ * Description:	Run the lexer until the end of the source, publishing
+ *		each token as it is scanned.  This is the body of the
+ *		lexer thread.  We keep our own copy of the head and only
+ *		reload it when the ring appears to be full.
+ */
+
+void TokenStream::produce()
+{
+    unsigned long head, tail;
+    Token *token;
+
+
+    head = tail = 0;
+
+    do {
+	while (tail - head == _capacity) {
+	    if (_stop.load(memory_order_relaxed))
+		return;
+
+	    if ((head = _head.load(memory_order_acquire)) + _capacity == tail)
+		this_thread::yield();
+	}
+
+	token = &_ring[tail & (_capacity - 1)];
+	_lexer.scan(*token);
+	_tail.store(++ tail, memory_order_release);
+
+    } while (token->kind != DONE);
+}
+
+
+/*
+ * Function:	TokenStream::fill (private)
+ *
+ * Description:	Wait until the token at the given position is available.
+ *		If we are not pipelined, we simply scan tokens ourselves.
+ *		In either case, once we see the end of the source we
+ *		remember where it is, since there will be nothing after.
+ *		We only look at a token that has just become available,
+ *		since the slot of one that has been consumed may already
+ *		be in use again by the lexer thread.
+ */
+
+void TokenStream::fill(unsigned long index)
+{
+    unsigned long before;
+
+
+    while (index >= _available && _end == ULONG_MAX) {
+	before = _available;
+
+	if (_pipelined) {
+	    _available = _tail.load(memory_order_acquire);
+
+	    if (index >= _available)
+		this_thread::yield();
+
+	} else {
+	    _lexer.scan(_ring[_available & (_capacity - 1)]);
+	    _tail.store(++ _available, memory_order_relaxed);
+	}
+
+	if (_available > before
+		&& _ring[(_available - 1) & (_capacity - 1)].kind == DONE)
+	    _end = _available - 1;
+    }
+}
+
+
+/*
+ * Function:	TokenStream::observe (private)
+ *
+ * Description:	Note that the parser has looked at all tokens up to and
+ *		including the given position.  For any token not seen
+ *		before, we update the current lexeme, just as a
+ *		conventional lexer would have when returning the token,
+ *		and report any lexical error.
+ */
+
+void TokenStream::observe(unsigned long index)
+{
+    const Token *token;
+
+
+    while (_seen <= index) {
+	token = &_ring[_seen ++ & (_capacity - 1)];
+	_reporter.text(text(*token));
+
+	if (token->error != LEX_OK && !_quiet)
+	    _reporter.report(*token);
+    }
+}
+
+
+/*
+ * Function:	TokenStream::peek
+ *
+ * Description:	Return the token k positions ahead without consuming it.
+ *		Looking past the end of the source simply returns the
+ *		final token again.
+ */
+
+const Token &TokenStream::peek(unsigned k)
+{
+    unsigned long index;
+
+
+    assert(k < _capacity);
+    index = _head.load(memory_order_relaxed) + k;
+    fill(index);
+
+    if (index > _end)
+	index = _end;
+
+    observe(index);
+    return _ring[index & (_capacity - 1)];
+}
+
+
+/*
+ * Function:	TokenStream::next
+ *
+ * Description:	Consume and return the next token.  The final token is
+ *		never consumed, so it is returned forever after.
+ */
+
+Token TokenStream::next()
+{
+    Token token;
+
+
+    token = peek();
+
+    if (token.kind != DONE)
+	_head.store(_head.load(memory_order_relaxed) + 1, memory_order_release);
+
+    return token;
+}
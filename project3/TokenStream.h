@@ -0,0 +1,71 @@
+/*
+ * File:	TokenStream.h
+ *
+ * Description:	This file contains the class definition for token streams
+ *		in Tiny C.  A token stream sits between the lexer and the
+ *		parser and gives the parser arbitrary lookahead.
+ *
+ *		Tokens are kept in a ring buffer.  Normally the parser
+ *		fills the ring itself by calling the lexer on demand.  In
+ *		pipelined mode, a dedicated thread runs the lexer ahead of
+ *		the parser and fills the ring concurrently.  There is only
+ *		ever one producer and one consumer, so the ring needs no
+ *		locks: the producer publishes each token by advancing the
+ *		tail and the consumer frees each slot by advancing the
+ *		head.
+ */
+
+# ifndef TOKENSTREAM_H
+# define TOKENSTREAM_H
+# include <atomic>
+# include <thread>
+# include <string_view>
+# include "lexer.h"
+# include "Reporter.h"
+
+class TokenStream {
+    typedef std::string_view string_view;
+    typedef std::atomic<unsigned long> counter;
+
+    const Source &_source;
+    Reporter &_reporter;
+    Lexer _lexer;
+    Token *_ring;
+    unsigned long _capacity;
+
+    bool _pipelined, _quiet;
+    std::thread _thread;
+    std::atomic<bool> _stop;
+
+    alignas(64) counter _head;
+    unsigned long _available, _seen, _end;
+    alignas(64) counter _tail;
+
+    void produce();
+    void fill(unsigned long index);
+    void observe(unsigned long index);
+
+public:
+    TokenStream(Reporter &reporter, bool pipelined = false);
+    TokenStream(Reporter &reporter, size_t offset);
+    ~TokenStream();
+
+    TokenStream(const TokenStream &) = delete;
+    TokenStream &operator =(const TokenStream &) = delete;
+
+    const Source &source() const { return _source; }
+    void quiet(bool quiet) { _quiet = quiet; }
+
+    const Token &peek(unsigned k = 0);
+    Token next();
+
+    string_view text(const Token &token) const {
+	return _source.text(token.offset, token.length);
+    }
+
+    string_view literal(const Token &token) const {
+	return _lexer.literal(token);
+    }
+};
+
+# endif /* TOKENSTREAM_H */
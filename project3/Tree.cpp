@@ -0,0 +1,195 @@
+/*
+ * File:	Tree.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		abstract syntax trees in Tiny C.  Besides the first child
+ *		and next sibling of each node, we keep its last child so
+ *		that appending a child takes constant time.
+ */
+
+# include "Tree.h"
+
+using namespace std;
+
+static const size_t reserved = 128;
+
+
+/*
+ * Function:	Tree::Tree (constructor)
+ *
+ * Description:	Initialize this tree to have no nodes.  A parser for a
+ *		single function body makes a tree of its own, so we reserve
+ *		room for a typical function up front rather than growing
+ *		every array a node at a time.
+ */
+
+Tree::Tree()
+{
+    _tokens.reserve(reserved);
+    _symbols.reserve(reserved);
+    _types.reserve(reserved);
+    _first.reserve(reserved);
+    _next.reserve(reserved);
+    _last.reserve(reserved);
+    _table.reserve(reserved);
+    _table.push_back(nullptr);
+}
+
+
+/*
+ * Function:	Tree::node
+ *
+ * Description:	Make a node with the specified token and symbol.  The
+ *		node has no children.  If the node has a symbol, then its
+ *		type is that of the symbol, and otherwise it is int.  A
+ *		symbol used before in this tree keeps its entry in the
+ *		table.
+ */
+
+Node Tree::node(int token, Symbol *symbol)
+{
+    Node node = _tokens.size();
+
+
+    _tokens.push_back(token);
+    _symbols.push_back(0);
+    _types.push_back(symbol != nullptr ? symbol->type() : Type(INT));
+    _first.push_back(none);
+    _next.push_back(none);
+    _last.push_back(none);
+
+    if (symbol != nullptr) {
+	auto result = _indices.emplace(symbol, _table.size());
+
+	if (result.second)
+	    _table.push_back(symbol);
+
+	_symbols.back() = result.first->second;
+    }
+
+    return node;
+}
+
+
+/*
+ * Function:	Tree::node
+ *
+ * Description:	Make a node with the specified token and children.  The
+ *		node has no symbol.  If the node represents an array index
+ *		or function call, then its type is a scalar with the same
+ *		specifier as that of its left child, which is the array or
+ *		function.  Otherwise, its type is int.
+ */
+
+Node Tree::node(int token, Node left, Node right)
+{
+    Node node = this->node(token);
+
+
+    append(node, left);
+
+    if (right != none)
+	append(node, right);
+
+    if (token == INDEX || token == FUNC || token == PROC)
+	_types[node] = Type(_types[left].specifier());
+
+    return node;
+}
+
+
+/*
+ * Function:	Tree::append
+ *
+ * Description:	Append the given child to the children of the given
+ *		parent.  A node is the child of at most one parent.
+ */
+
+void Tree::append(Node parent, Node child)
+{
+    if (_last[parent] == none)
+	_first[parent] = child;
+    else
+	_next[_last[parent]] = child;
+
+    _last[parent] = child;
+}
+
+
+/*
+ * Function:	Tree::clear
+ *
+ * Description:	Remove every node from this tree.  The arrays keep their
+ *		memory for the next tree.
+ */
+
+void Tree::clear()
+{
+    _tokens.clear();
+    _symbols.clear();
+    _types.clear();
+    _first.clear();
+    _next.clear();
+    _last.clear();
+    _table.resize(1);
+    _indices.clear();
+}
+
+
+/*
+ * Function:	Tree::children
+ *
+ * Description:	Return the number of children of the given node.
+ */
+
+unsigned Tree::children(Node node) const
+{
+    unsigned count = 0;
+
+
+    for (Node child = _first[node]; child != none; child = _next[child])
+	count ++;
+
+    return count;
+}
+
+
+/*
+ * Function:	Tree::write
+ *
+ * Description:	Write the tree with the given root to the specified output
+ *		stream.  A node with a symbol is written as the name of the
+ *		symbol, which is found in the given table of atoms, and any
+ *		other node as its token and children in parentheses.
+ */
+
+ostream &Tree::write(ostream &ostr, Node root, const Atoms &atoms) const
+{
+    struct Writer {
+	const Tree &tree;
+	const Atoms &atoms;
+	ostream &ostr;
+	Node root;
+
+	bool enter(Node node) {
+	    if (node != root)
+		ostr << " ";
+
+	    if (tree.symbol(node) != nullptr) {
+		ostr << atoms.name(tree.symbol(node)->atom());
+		return false;
+	    }
+
+	    ostr << "(" << tokenTable[tree.token(node)].lexeme;
+	    return true;
+	}
+
+	void leave(Node node) {
+	    ostr << ")";
+	}
+    } writer = {*this, atoms, ostr, root};
+
+
+    visit(root, writer);
+    return ostr;
+}
@@ -0,0 +1,120 @@
+/*
+ * File:	Tree.h
+ *
+ * Description:	This file contains the class definition for abstract
+ *		syntax trees in Tiny C.  Rather than each node being an
+ *		object of its own with a vector of children, the nodes of
+ *		a tree are kept in parallel arrays and a node is simply
+ *		its index in them.  For each node, we keep its token, the
+ *		index of its symbol, if any, and the indices of its first
+ *		child and next sibling, all in 32 bits.  The symbols are
+ *		kept in a table of their own, with one entry for each
+ *		distinct symbol in the order of first use, and index zero
+ *		means no symbol at all.
+ *
+ *		The type of each node is worked out once, when the node is
+ *		made, and kept alongside it, so that asking for the type
+ *		of an expression is simply a lookup.  Since a node is
+ *		always made after its operands, this is the same as a
+ *		single pass over the tree from the bottom up.
+ *
+ *		A tree holds every node of one function, and is cleared
+ *		once the function is written out, but keeps its arrays so
+ *		that the next function hardly ever needs to allocate.
+ *
+ *		A pass over a tree may simply run through the nodes in the
+ *		order they were made, from zero up to the size of the
+ *		tree.  Since the operands of an expression are always made
+ *		before the expression itself, such a pass sees every
+ *		operand before the expression that uses it.  A pass that
+ *		needs the structure instead gives a visitor to visit(),
+ *		which calls its enter() on the way down to each node and
+ *		its leave() on the way back up.  If enter() returns false,
+ *		the children of the node are skipped, and leave() is not
+ *		called for it.
+ */
+
+# ifndef TREE_H
+# define TREE_H
+# include <cstdint>
+# include <ostream>
+# include <unordered_map>
+# include <vector>
+# include "tokens.h"
+# include "Symbol.h"
+
+typedef uint32_t Node;
+
+class Tree {
+    std::vector<int> _tokens;
+    std::vector<uint32_t> _symbols;
+    std::vector<Type> _types;
+    std::vector<Node> _first, _next, _last;
+    std::vector<Symbol *> _table;
+    std::unordered_map<Symbol *, uint32_t> _indices;
+
+public:
+    static constexpr Node none = UINT32_MAX;
+
+    Tree();
+
+    Node node(int token, Symbol *symbol = nullptr);
+    Node node(int token, Node left, Node right = none);
+    void append(Node parent, Node child);
+    void clear();
+
+    Node size() const { return _tokens.size(); }
+    int token(Node node) const { return _tokens[node]; }
+    Symbol *symbol(Node node) const { return _table[_symbols[node]]; }
+    Node first(Node node) const { return _first[node]; }
+    Node next(Node node) const { return _next[node]; }
+    Type type(Node node) const { return _types[node]; }
+
+    unsigned children(Node node) const;
+
+    template<class Visitor> void visit(Node root, Visitor &visitor) const;
+    std::ostream &write(std::ostream &ostr, Node root,
+	const Atoms &atoms) const;
+};
+
+
+/*
+ * Function:	Tree::visit
+ *
+ * Description:	Visit the tree with the given root in depth-first order.
+ *		Trees may be arbitrarily deep, so rather than recursing, we
+ *		keep a stack of the nodes whose children are being visited.
+ */
+
+template<class Visitor>
+void Tree::visit(Node root, Visitor &visitor) const
+{
+    std::vector<Node> open;
+    Node node = root;
+
+
+    while (1) {
+	if (visitor.enter(node)) {
+	    if (_first[node] != none) {
+		open.push_back(node);
+		node = _first[node];
+		continue;
+	    }
+
+	    visitor.leave(node);
+	}
+
+	while (node != root && _next[node] == none) {
+	    node = open.back();
+	    open.pop_back();
+	    visitor.leave(node);
+	}
+
+	if (node == root)
+	    return;
+
+	node = _next[node];
+    }
+}
+
+# endif /* TREE_H */
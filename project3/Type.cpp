@@ -6,39 +6,45 @@
  *		function, as indicated by its declarator.
  *
  *		Types are immutable, as only accessors are provided.  The
- *		declarator is inferred from the constructor.
+ *		number of a type has its declarator in the low two bits,
+ *		then a bit that is set for char, and then the index of its
+ *		record in the type table.  Scalars have no record, and an
+ *		array of unknown length, which can only be a parameter and
+ *		so is really a pointer, has none either, so index zero is
+ *		never used for a record.
+ *
+ *		The table finds the number of an array or function type
+ *		with an open-addressing hash table with linear probing
+ *		that is never more than half full.  Each record keeps the
+ *		size of its type, so that it is worked out only once.
+ *		Function bodies may be parsed on several threads at once,
+ *		so a concurrent table is protected by a lock, which only
+ *		needs to be shared unless a new type is being added.
  */
 
 # include <cassert>
+# include <mutex>
 # include "machine.h"
 # include "tokens.h"
 # include "Type.h"
 
 using namespace std;
 
-enum { ARRAY, FUNCTION, SCALAR };
+enum { SCALAR, ARRAY, FUNCTION };
 
-
-/*
- * Function:	Type::Type (constructor)
- *
- * Description:	Initialize this type as a scalar type.
- */
-
-Type::Type(int specifier)
-    : _declarator(SCALAR), _specifier(specifier)
-{
-}
+static const unsigned kindMask = 7, declaratorMask = 3, charBit = 4;
+static const unsigned indexShift = 3;
 
 
 /*
- * Function:	Type::Type (constructor)
+ * Function:	Type::Type (constructor, private)
  *
- * Description:	Initialize this type as an array type.
+ * Description:	Initialize this type with the given declarator and
+ *		specifier, and the given index of its record.
  */
 
-Type::Type(int specifier, unsigned length)
-    : _declarator(ARRAY), _specifier(specifier), _length(length)
+Type::Type(int declarator, int specifier, uint32_t index)
+    : _id(index << indexShift | (specifier == CHAR ? charBit : 0) | declarator)
 {
 }
 
@@ -46,11 +52,11 @@ Type::Type(int specifier, unsigned length)
 /*
  * Function:	Type::Type (constructor)
  *
- * Description:	Initialize this type as a function type.
+ * Description:	Initialize this type as a scalar type.
  */
 
-Type::Type(int specifier, Types *parameters)
-    : _declarator(FUNCTION), _specifier(specifier), _parameters(parameters)
+Type::Type(int specifier)
+    : Type(SCALAR, specifier, 0)
 {
 }
 
@@ -63,7 +69,7 @@ Type::Type(int specifier, Types *parameters)
 
 bool Type::isArray() const
 {
-    return _declarator == ARRAY;
+    return (_id & declaratorMask) == ARRAY;
 }
 
 
@@ -75,7 +81,7 @@ bool Type::isArray() const
 
 bool Type::isFunction() const
 {
-    return _declarator == FUNCTION;
+    return (_id & declaratorMask) == FUNCTION;
 }
 
 
@@ -87,7 +93,7 @@ bool Type::isFunction() const
 
 bool Type::isScalar() const
 {
-    return _declarator == SCALAR;
+    return (_id & declaratorMask) == SCALAR;
 }
 
 
@@ -101,7 +107,7 @@ bool Type::isScalar() const
 
 bool Type::isPointer() const
 {
-    return _declarator == ARRAY && _length == 0;
+    return isArray() && (_id >> indexShift) == 0;
 }
 
 
@@ -113,53 +119,312 @@ bool Type::isPointer() const
 
 int Type::specifier() const
 {
-    return _specifier;
+    return _id & charBit ? CHAR : INT;
+}
+
+
+/*
+ * Function:	Type::id (accessor)
+ *
+ * Description:	Return the number of this type.
+ */
+
+uint32_t Type::id() const
+{
+    return _id;
+}
+
+
+/*
+ * Function:	hashType
+ *
+ * Description:	Return a hash of the type with the given number, which
+ *		does not include an index, and the given length and
+ *		parameters.
+ */
+
+static unsigned hashType(uint32_t id, unsigned length,
+	const Types *parameters)
+{
+    unsigned hash = (id * 31 + length) * 2654435761U;
+
+
+    if (parameters != nullptr) {
+	hash ^= 0x9e3779b9U;
+
+	for (const auto &type : *parameters)
+	    hash = (hash ^ type.id()) * 16777619U;
+    }
+
+    return hash;
+}
+
+
+/*
+ * Function:	same
+ *
+ * Description:	Return whether the given parameter lists are the same.
+ *		An unspecified list is only the same as another one.
+ */
+
+static bool same(const Types *left, const Types *right)
+{
+    if (left == nullptr || right == nullptr)
+	return left == right;
+
+    return *left == *right;
+}
+
+
+/*
+ * Function:	TypeTable::TypeTable (constructor)
+ *
+ * Description:	Initialize this type table to be empty, and to be safe for
+ *		use by several threads at once if asked.
+ */
+
+TypeTable::TypeTable(bool concurrent)
+    : _concurrent(concurrent), _records(1), _table(64, Type(INT))
+{
+}
+
+
+/*
+ * Function:	TypeTable::record (private)
+ *
+ * Description:	Return the record of the given array or function type.
+ *		The caller must hold the lock if it is needed.
+ */
+
+const TypeTable::Record &TypeTable::record(Type type) const
+{
+    assert(type._id >> indexShift < _records.size());
+    return _records[type._id >> indexShift];
+}
+
+
+/*
+ * Function:	TypeTable::slot (private)
+ *
+ * Description:	Return the slot in the hash table for the type with the
+ *		given hash, the declarator and specifier of the given key,
+ *		and the given length and parameters, which is either its
+ *		slot or the empty slot where it would go.
+ */
+
+size_t TypeTable::slot(unsigned hash, Type key, unsigned length,
+	const Types *parameters) const
+{
+    unsigned mask = _table.size() - 1;
+    unsigned h = hash & mask;
+
+
+    while (_table[h]._id != 0) {
+	const Record &r = record(_table[h]);
+
+	if (r.hash == hash && (_table[h]._id & kindMask) == key._id
+		&& r.length == length && same(r.parameters, parameters))
+	    break;
+
+	h = (h + 1) & mask;
+    }
+
+    return h;
+}
+
+
+/*
+ * Function:	TypeTable::grow (private)
+ *
+ * Description:	Double the size of the hash table and reinsert every
+ *		type.
+ */
+
+void TypeTable::grow()
+{
+    vector<Type> old(_table.size() * 2, Type(INT));
+    unsigned mask = old.size() - 1;
+    unsigned h;
+
+
+    old.swap(_table);
+
+    for (const auto &type : old)
+	if (type._id != 0) {
+	    for (h = record(type).hash & mask; _table[h]._id != 0; )
+		h = (h + 1) & mask;
+
+	    _table[h] = type;
+	}
+}
+
+
+/*
+ * Function:	TypeTable::insert (private)
+ *
+ * Description:	Return the type with the declarator and specifier of the
+ *		given key and the given length and parameters, adding it to
+ *		the table if it is not there already.  The parameters are
+ *		copied into the table, and the size of the type is worked
+ *		out once and for all.
+ */
+
+Type TypeTable::insert(Type key, unsigned length, const Types *parameters)
+{
+    unsigned hash = hashType(key._id, length, parameters);
+    size_t h = slot(hash, key, length, parameters);
+    Type type(INT);
+    Record r;
+
+
+    if (_table[h]._id != 0)
+	return _table[h];
+
+    if (2 * (_records.size() + 1) > _table.size()) {
+	grow();
+	h = slot(hash, key, length, parameters);
+    }
+
+    r.hash = hash;
+    r.length = length;
+    r.parameters = nullptr;
+
+    if (parameters != nullptr)
+	r.parameters = new (_arena) Types(parameters->begin(),
+	    parameters->end(), Types::allocator_type(_arena));
+
+    r.size = key.specifier() == INT ? SIZEOF_INT : SIZEOF_CHAR;
+
+    if (key.isArray())
+	r.size *= length;
+
+    type = Type(key._id & declaratorMask, key.specifier(), _records.size());
+    _records.push_back(r);
+    _table[h] = type;
+    return type;
+}
+
+
+/*
+ * Function:	TypeTable::intern (private)
+ *
+ * Description:	Return the type with the declarator and specifier of the
+ *		given key and the given length and parameters, taking the
+ *		lock if need be.
+ */
+
+Type TypeTable::intern(Type key, unsigned length, const Types *parameters)
+{
+    unsigned hash;
+    size_t h;
+
+
+    if (!_concurrent)
+	return insert(key, length, parameters);
+
+    hash = hashType(key._id, length, parameters);
+
+    {
+	shared_lock<shared_mutex> guard(_lock);
+
+	if (_table[h = slot(hash, key, length, parameters)]._id != 0)
+	    return _table[h];
+    }
+
+    lock_guard<shared_mutex> guard(_lock);
+    return insert(key, length, parameters);
+}
+
+
+/*
+ * Function:	TypeTable::array
+ *
+ * Description:	Return the array type with the given specifier and
+ *		length.  An array of unknown length has no record.
+ */
+
+Type TypeTable::array(int specifier, unsigned length)
+{
+    if (length == 0)
+	return Type(ARRAY, specifier, 0);
+
+    return intern(Type(ARRAY, specifier, 0), length, nullptr);
 }
 
 
 /*
- * Function:	Type::length (accessor)
+ * Function:	TypeTable::function
  *
- * Description:	Return the length of this type, which must be an array.
+ * Description:	Return the function type with the given specifier and
+ *		parameters, which may be null if they are unspecified.
  */
 
-unsigned Type::length() const
+Type TypeTable::function(int specifier, const Types *parameters)
 {
-    assert(_declarator == ARRAY);
-    return _length;
+    return intern(Type(FUNCTION, specifier, 0), 0, parameters);
 }
 
 
 /*
- * Function:	Type::parameters (accessor)
+ * Function:	TypeTable::length
  *
- * Description:	Return the parameters of this type, which must be a
- *		function.
+ * Description:	Return the length of the given type, which must be an
+ *		array.
  */
 
-Types *Type::parameters() const
+unsigned TypeTable::length(Type type) const
 {
-    assert(_declarator == FUNCTION);
-    return _parameters;
+    assert(type.isArray());
+
+    if (type.isPointer())
+	return 0;
+
+    if (!_concurrent)
+	return record(type).length;
+
+    shared_lock<shared_mutex> guard(_lock);
+    return record(type).length;
 }
 
 
 /*
- * Function:	Type::size
+ * Function:	TypeTable::parameters
  *
- * Description:	Return the size of this type in bytes.  The size of an
- *		array is the length of the array multiplied by the size of
- *		a single element in the array.
+ * Description:	Return the parameters of the given type, which must be a
+ *		function.  The parameters last as long as the table does.
  */
 
-unsigned Type::size() const
+const Types *TypeTable::parameters(Type type) const
 {
-    unsigned count;
+    assert(type.isFunction());
 
+    if (!_concurrent)
+	return record(type).parameters;
+
+    shared_lock<shared_mutex> guard(_lock);
+    return record(type).parameters;
+}
 
-    if (isPointer())
+
+/*
+ * Function:	TypeTable::size
+ *
+ * Description:	Return the size of the given type in bytes.  The size of
+ *		an array is the length of the array multiplied by the size
+ *		of a single element in the array.
+ */
+
+unsigned TypeTable::size(Type type) const
+{
+    if (type.isScalar())
+	return type.specifier() == INT ? SIZEOF_INT : SIZEOF_CHAR;
+
+    if (type.isPointer())
 	return SIZEOF_PTR;
 
-    count = (_declarator == ARRAY ? _length : 1);
-    return count * (_specifier == INT ? SIZEOF_INT : SIZEOF_CHAR);
+    if (!_concurrent)
+	return record(type).size;
+
+    shared_lock<shared_mutex> guard(_lock);
+    return record(type).size;
 }
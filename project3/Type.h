@@ -1,7 +1,7 @@
 /*
  * File:	Type.h
  *
- * Description:	This file contains the class definition for types in Tiny
+ * Description:	This file contains the class definitions for types in Tiny
  *		C.  A type is either a scalar, an array, or a function, as
  *		indicated by its declarator.  An array type also includes
  *		its length, and a function type includes its parameters.
@@ -9,23 +9,34 @@
  *		By convention, a null parameter list represents an
  *		unspecified parameter list, and an empty parameter list is
  *		represented by an empty vector.
+ *
+ *		Each distinct type exists only once, in the type table of
+ *		its compilation, and a type is simply a 32-bit number that
+ *		identifies it, so two types are the same exactly when
+ *		their numbers are.  The declarator and specifier are kept
+ *		in the number itself, so a scalar or a pointer needs no
+ *		table at all, and most questions about a type can be
+ *		answered without one.  Only an array or function type
+ *		needs the table, for its length or its parameters.
  */
 
 # ifndef TYPE_H
 # define TYPE_H
+# include <cstdint>
+# include <shared_mutex>
 # include <vector>
+# include "Arena.h"
 
-typedef std::vector<class Type> Types;
+typedef std::vector<class Type, ArenaAllocator<class Type>> Types;
 
 class Type {
-    short _declarator, _specifier;
-    unsigned _length;
-    Types *_parameters;
+    friend class TypeTable;
+    uint32_t _id;
+
+    Type(int declarator, int specifier, uint32_t index);
 
 public:
     Type(int specifier);
-    Type(int specifier, unsigned length);
-    Type(int specifier, Types *parameters);
 
     bool isArray() const;
     bool isFunction() const;
@@ -33,10 +44,43 @@ public:
     bool isPointer() const;
 
     int specifier() const;
-    unsigned length() const;
-    Types *parameters() const;
+    uint32_t id() const;
+
+    bool operator ==(const Type &that) const { return _id == that._id; }
+    bool operator !=(const Type &that) const { return _id != that._id; }
+};
+
+class TypeTable {
+    struct Record {
+	unsigned hash, length, size;
+	const Types *parameters;
+    };
+
+    bool _concurrent;
+    mutable std::shared_mutex _lock;
+    Arena _arena;
+    std::vector<Record> _records;
+    std::vector<Type> _table;
+
+    const Record &record(Type type) const;
+    size_t slot(unsigned hash, Type key, unsigned length,
+	const Types *parameters) const;
+    void grow();
+    Type insert(Type key, unsigned length, const Types *parameters);
+    Type intern(Type key, unsigned length, const Types *parameters);
+
+public:
+    TypeTable(bool concurrent = false);
+
+    TypeTable(const TypeTable &) = delete;
+    TypeTable &operator =(const TypeTable &) = delete;
+
+    Type array(int specifier, unsigned length);
+    Type function(int specifier, const Types *parameters);
 
-    unsigned size() const;
+    unsigned length(Type type) const;
+    const Types *parameters(Type type) const;
+    unsigned size(Type type) const;
 };
 
 # endif /* TYPE_H */
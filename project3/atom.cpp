@@ -0,0 +1,201 @@
+/*
+ * File:	atom.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		tables of identifiers in Tiny C.
+ *
+ *		The atom of an identifier is its index in a vector of
+ *		names, which are kept in an arena and so never move.  To
+ *		find the atom of a name, we use an open-addressing hash
+ *		table with linear probing that is never more than half
+ *		full.  Each entry keeps the full hash of its name, so we
+ *		hardly ever compare names that differ.
+ *
+ *		The lexer may be running on a thread of its own, and
+ *		function bodies may be scanned again on several threads at
+ *		once, so a concurrent table is protected by a lock.  Nearly
+ *		every identifier is seen before, so looking up a name only
+ *		needs to share the lock, and only inserting a new one takes
+ *		it for itself.  A table used by only one thread at a time
+ *		does not bother with the lock at all.
+ */
+
+# include <mutex>
+# include "atom.h"
+
+using namespace std;
+
+
+/*
+ * Function:	hashName
+ *
+ * Description:	Return the FNV-1a hash of the given name.
+ */
+
+static unsigned hashName(string_view name)
+{
+    unsigned hash = 2166136261U;
+
+
+    for (char c : name)
+	hash = (hash ^ (unsigned char) c) * 16777619U;
+
+    return hash;
+}
+
+
+/*
+ * Function:	Atoms::Atoms (constructor)
+ *
+ * Description:	Initialize this table of atoms to be empty, and to be
+ *		safe for use by several threads at once if asked.
+ */
+
+Atoms::Atoms(bool concurrent)
+    : _concurrent(concurrent), _names(1), _table(256)
+{
+}
+
+
+/*
+ * Function:	Atoms::find (private)
+ *
+ * Description:	Return the atom of the given name with the given hash, or
+ *		zero if there is none.
+ */
+
+Atom Atoms::find(string_view name, unsigned hash) const
+{
+    unsigned mask = _table.size() - 1;
+    unsigned h = hash & mask;
+
+
+    while (_table[h].atom != 0) {
+	if (_table[h].hash == hash && _names[_table[h].atom] == name)
+	    return _table[h].atom;
+
+	h = (h + 1) & mask;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Function:	Atoms::grow (private)
+ *
+ * Description:	Double the size of the hash table and reinsert every
+ *		atom.
+ */
+
+void Atoms::grow()
+{
+    vector<Entry> old(_table.size() * 2);
+    unsigned mask = old.size() - 1;
+    unsigned h;
+
+
+    old.swap(_table);
+
+    for (const auto &entry : old)
+	if (entry.atom != 0) {
+	    for (h = entry.hash & mask; _table[h].atom != 0; h = (h + 1) & mask)
+		continue;
+
+	    _table[h] = entry;
+	}
+}
+
+
+/*
+ * Function:	Atoms::insert (private)
+ *
+ * Description:	Return the atom of the given name with the given hash,
+ *		giving it a new atom if it has none.
+ */
+
+Atom Atoms::insert(string_view name, unsigned hash)
+{
+    unsigned mask;
+    unsigned h;
+    Atom atom;
+
+
+    if ((atom = find(name, hash)) != 0)
+	return atom;
+
+    if (2 * _names.size() > _table.size())
+	grow();
+
+    mask = _table.size() - 1;
+
+    for (h = hash & mask; _table[h].atom != 0; h = (h + 1) & mask)
+	continue;
+
+    atom = _names.size();
+    _names.push_back(_arena.copy(name));
+    _table[h] = {hash, atom};
+    return atom;
+}
+
+
+/*
+ * Function:	Atoms::intern
+ *
+ * Description:	Return the atom of the given name, giving it a new atom
+ *		if it is the first time we have seen it.
+ */
+
+Atom Atoms::intern(string_view name)
+{
+    unsigned hash = hashName(name);
+    Atom atom;
+
+
+    if (!_concurrent)
+	return insert(name, hash);
+
+    {
+	shared_lock<shared_mutex> guard(_lock);
+
+	if ((atom = find(name, hash)) != 0)
+	    return atom;
+    }
+
+    lock_guard<shared_mutex> guard(_lock);
+    return insert(name, hash);
+}
+
+
+/*
+ * Function:	Atoms::name
+ *
+ * Description:	Return the name of the given atom.  The name lasts as long
+ *		as the table does.
+ */
+
+string_view Atoms::name(Atom atom) const
+{
+    if (!_concurrent)
+	return _names[atom];
+
+    shared_lock<shared_mutex> guard(_lock);
+    return _names[atom];
+}
+
+
+/*
+ * Function:	Atoms::size
+ *
+ * Description:	Return the number of atoms so far, including atom zero,
+ *		so that a vector of this size can be indexed by any atom.
+ */
+
+size_t Atoms::size() const
+{
+    if (!_concurrent)
+	return _names.size();
+
+    shared_lock<shared_mutex> guard(_lock);
+    return _names.size();
+}
@@ -0,0 +1,52 @@
+/*
+ * File:	atom.h
+ *
+ * Description:	This file contains the class definition for the table of
+ *		identifiers in Tiny C.  Each identifier is interned once,
+ *		when the lexer first scans it, and is known from then on
+ *		by its atom, a small integer, so that symbols and scopes
+ *		compare atoms rather than names.  Atom zero is never used
+ *		for an identifier, so it may stand for none at all.  Each
+ *		compilation has its own table of atoms.
+ */
+
+# ifndef ATOM_H
+# define ATOM_H
+# include <cstdint>
+# include <shared_mutex>
+# include <string_view>
+# include <vector>
+# include "Arena.h"
+
+typedef uint32_t Atom;
+
+class Atoms {
+    typedef std::string_view string_view;
+
+    struct Entry {
+	unsigned hash;
+	Atom atom;
+    };
+
+    bool _concurrent;
+    mutable std::shared_mutex _lock;
+    Arena _arena;
+    std::vector<string_view> _names;
+    std::vector<Entry> _table;
+
+    Atom find(string_view name, unsigned hash) const;
+    Atom insert(string_view name, unsigned hash);
+    void grow();
+
+public:
+    Atoms(bool concurrent = false);
+
+    Atoms(const Atoms &) = delete;
+    Atoms &operator =(const Atoms &) = delete;
+
+    Atom intern(string_view name);
+    string_view name(Atom atom) const;
+    size_t size() const;
+};
+
+# endif /* ATOM_H */
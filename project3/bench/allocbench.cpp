@@ -0,0 +1,195 @@
+/*
+ * File:	allocbench.cpp
+ *
+ * Description:	This file contains a benchmark for the memory use of the
+ *		compiler for Tiny C.  It compiles the named file the given
+ *		number of times in one process, as a compile server would,
+ *		throwing the output away, and reports the number of heap
+ *		allocations and bytes allocated per compilation, the most
+ *		heap ever in use at once, and the peak resident set size.
+ *		The resident set size after the first compilation is also
+ *		reported, so any growth from one compilation to the next
+ *		shows up.  Any other arguments are compiler options.
+ *
+ *		  bench/replicate.sh 5000 ../project2/examples/legal/fib.c > in
+ *		  bench/allocbench -n 10 in
+ *		  bench/allocbench -n 10 -j 4 in
+ */
+
+# include <atomic>
+# include <cstdio>
+# include <cstdlib>
+# include <cstring>
+# include <iostream>
+# include <new>
+# include <malloc.h>
+# include <unistd.h>
+# include <sys/resource.h>
+# include "../CompilationContext.h"
+# include "../Source.h"
+# include "../parser.h"
+
+using namespace std;
+
+static atomic<unsigned long> allocations, allocated;
+static atomic<long> live, highest;
+
+
+/*
+ * Function:	operator new
+ *
+ * Description:	Allocate memory from the heap, counting the allocation
+ *		and keeping track of how much is in use.  The size of each
+ *		block is taken from the allocator so that it can be
+ *		subtracted again when the block is freed.
+ */
+
+void *operator new(size_t size)
+{
+    void *p;
+    long now;
+
+
+    if ((p = malloc(size)) == nullptr)
+	throw bad_alloc();
+
+    allocations ++;
+    allocated += size;
+    now = live += malloc_usable_size(p);
+
+    for (long top = highest; now > top; )
+	if (highest.compare_exchange_weak(top, now))
+	    break;
+
+    return p;
+}
+
+
+/*
+ * Function:	operator delete
+ *
+ * Description:	Return memory to the heap.
+ */
+
+void operator delete(void *p) noexcept
+{
+    if (p != nullptr) {
+	live -= malloc_usable_size(p);
+	free(p);
+    }
+}
+
+
+/*
+ * Function:	operator delete
+ *
+ * Description:	Return memory of a known size to the heap.
+ */
+
+void operator delete(void *p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+
+/*
+ * Function:	residentSize
+ *
+ * Description:	Return the resident set size of this process in
+ *		kilobytes, or the peak resident set size if asked.
+ */
+
+static long residentSize(bool peak)
+{
+    unsigned long pages, resident;
+    struct rusage usage;
+    FILE *fp;
+
+
+    if (peak) {
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+    }
+
+    if ((fp = fopen("/proc/self/statm", "r")) == nullptr)
+	return 0;
+
+    if (fscanf(fp, "%lu %lu", &pages, &resident) != 2)
+	resident = 0;
+
+    fclose(fp);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+
+/*
+ * Function:	compileOnce
+ *
+ * Description:	Compile the given source with the given options, throwing
+ *		away the output and diagnostics along with the context.
+ */
+
+static void compileOnce(const Source &source, const Options &options)
+{
+    ostream discard(nullptr);
+    CompilationContext context(source, options, discard, discard);
+
+
+    compile(context);
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Compile the named file repeatedly and report its memory
+ *		use.
+ */
+
+int main(int argc, char *argv[])
+{
+    vector<string> args, operands;
+    unsigned long count, bytes;
+    unsigned runs = 1;
+    long first = 0;
+    Options options;
+    Source source;
+
+
+    for (int i = 1; i < argc; i ++)
+	if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+	    runs = atoi(argv[++ i]);
+	else
+	    args.push_back(argv[i]);
+
+    if (!options.parse(args, operands) || operands.size() != 1 || runs == 0) {
+	cerr << "usage: " << argv[0] << " [-n runs] [options] file" << endl;
+	return EXIT_FAILURE;
+    }
+
+    if (!source.open(operands[0].c_str())) {
+	cerr << argv[0] << ": cannot open " << operands[0] << endl;
+	return EXIT_FAILURE;
+    }
+
+    count = allocations;
+    bytes = allocated;
+
+    for (unsigned i = 0; i < runs; i ++) {
+	compileOnce(source, options);
+
+	if (i == 0)
+	    first = residentSize(false);
+    }
+
+    count = (allocations - count) / runs;
+    bytes = (allocated - bytes) / runs;
+
+    cout << count << " allocations and " << bytes / 1024;
+    cout << " KB allocated per compilation" << endl;
+    cout << highest / 1024 << " KB of heap in use at most" << endl;
+    cout << first << " KB resident after one compilation, ";
+    cout << residentSize(false) << " KB after " << runs << endl;
+    cout << residentSize(true) << " KB peak resident" << endl;
+    return 0;
+}
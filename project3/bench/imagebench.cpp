@@ -0,0 +1,164 @@
+/*
+ * File:	imagebench.cpp
+ *
+ * Description:	This file contains a benchmark for reading binary images,
+ *		which also serves as an example of how another process
+ *		reads one.  The image is mapped into memory and every node
+ *		of every function is visited where it lies, with nothing
+ *		read or copied beforehand, and the throughput is reported
+ *		in nodes per second.  With -w, the trees are instead
+ *		written out just as the compiler writes them as text, so
+ *		the two can be compared.
+ *
+ *		  bench/replicate.sh 20000 ../project2/examples/legal/fib.c > in
+ *		  ./tcc -fimage in > in.image
+ *		  bench/imagebench in.image
+ *		  bench/imagebench -w in.image | cmp - <(./tcc in)
+ */
+
+# include <chrono>
+# include <cstring>
+# include <iostream>
+# include <vector>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# include "../image.h"
+# include "../tokens.h"
+
+using namespace std;
+
+static volatile unsigned long sink;
+
+
+/*
+ * Function:	writeTree
+ *
+ * Description:	Write the tree of the given function section with the
+ *		given root to the given stream.  As in the compiler, a
+ *		node with a symbol is written as its name, and any other
+ *		node as its token and children in parentheses.
+ */
+
+static void writeTree(ostream &ostr, const ImageSection &section, uint32_t root)
+{
+    vector<uint32_t> open;
+    uint32_t node = root;
+
+
+    while (1) {
+	const ImageNode &record = section.node(node);
+
+	if (node != root)
+	    ostr << " ";
+
+	if (record.symbol != IMAGE_NONE)
+	    ostr << section.name(section.symbol(record.symbol));
+	else {
+	    ostr << "(" << tokenTable[record.token].lexeme;
+
+	    if (record.first != IMAGE_NONE) {
+		open.push_back(node);
+		node = record.first;
+		continue;
+	    }
+
+	    ostr << ")";
+	}
+
+	while (node != root && section.node(node).next == IMAGE_NONE) {
+	    node = open.back();
+	    open.pop_back();
+	    ostr << ")";
+	}
+
+	if (node == root)
+	    return;
+
+	node = section.node(node).next;
+    }
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Map the named image and either walk or write its trees.
+ */
+
+int main(int argc, char *argv[])
+{
+    unsigned long nodes, sum;
+    bool writing;
+    struct stat info;
+    double seconds;
+    void *base;
+    int fd;
+
+
+    writing = argc == 3 && strcmp(argv[1], "-w") == 0;
+
+    if (argc != 2 + writing) {
+	cerr << "usage: " << argv[0] << " [-w] image" << endl;
+	return 1;
+    }
+
+    if ((fd = open(argv[argc - 1], O_RDONLY)) < 0 || fstat(fd, &info) < 0) {
+	cerr << argv[0] << ": cannot open " << argv[argc - 1] << endl;
+	return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+
+    base = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (base == MAP_FAILED) {
+	cerr << argv[0] << ": cannot map " << argv[argc - 1] << endl;
+	return 1;
+    }
+
+    Image image(base, info.st_size);
+
+    if (!image.valid()) {
+	cerr << argv[0] << ": " << argv[argc - 1] << " is not an image" << endl;
+	return 1;
+    }
+
+    nodes = sum = 0;
+
+    for (uint32_t i = 0; i < image.functions(); i ++) {
+	const ImageSection &section = image.function(i);
+
+	if (writing) {
+	    writeTree(cout, section, section.root);
+	    cout << '\n';
+	    continue;
+	}
+
+	for (uint32_t node = 0; node < section.nnodes; node ++) {
+	    const ImageNode &record = section.node(node);
+	    sum += record.token + record.type;
+
+	    if (record.symbol != IMAGE_NONE)
+		sum += section.symbol(record.symbol).value;
+	}
+
+	nodes += section.nnodes;
+    }
+
+    auto stop = chrono::steady_clock::now();
+    seconds = chrono::duration<double>(stop - start).count();
+
+    if (!writing) {
+	cout << image.functions() << " functions, " << nodes << " nodes in ";
+	cout << seconds << " seconds, ";
+	cout << (unsigned long) (nodes / seconds) << " nodes/sec" << endl;
+    }
+
+    sink = sum;
+
+    munmap(base, info.st_size);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * File:	lexbench.cpp
+ *
+ * Description:	This file contains a benchmark for the lexical analyzer
+ *		for Tiny C.  It tokenizes the standard input and reports
+ *		the throughput in tokens per second.  The same program is
+ *		also built against the flex scanner, with FLEX defined, so
+ *		that the two can be compared.  With -fpipeline, the tokens
+ *		are instead consumed through a pipelined token stream.
+ *
+ *		  bench/replicate.sh 20000 ../project2/examples/legal/fib.c > in
+ *		  bench/lexbench < in
+ *		  bench/lexbench -fpipeline < in
+ *		  bench/lexbench-flex < in
+ */
+
+# include <chrono>
+# include <cstring>
+# include <iostream>
+# include <unistd.h>
+# include "../tokens.h"
+
+# ifdef FLEX
+int yylex();
+# else
+# include "../TokenStream.h"
+# endif
+
+using namespace std;
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Tokenize the standard input and report the throughput.
+ */
+
+int main(int argc, char *argv[])
+{
+    unsigned long tokens;
+    double seconds;
+
+
+    tokens = 0;
+    auto start = chrono::steady_clock::now();
+
+# ifdef FLEX
+    while (yylex() != DONE)
+	tokens ++;
+# else
+    Options options;
+    Source source;
+    Token token;
+
+
+    source.open(STDIN_FILENO);
+    CompilationContext context(source, options, cout, cerr);
+    Reporter reporter(context);
+
+    if (argc > 1 && strcmp(argv[1], "-fpipeline") == 0) {
+	TokenStream stream(reporter, true);
+
+	while (stream.next().kind != DONE)
+	    tokens ++;
+
+    } else {
+	Lexer lexer(source, context.atoms);
+
+	for (lexer.scan(token); token.kind != DONE; lexer.scan(token))
+	    tokens ++;
+    }
+# endif
+
+    auto stop = chrono::steady_clock::now();
+    seconds = chrono::duration<double>(stop - start).count();
+
+    cout << tokens << " tokens in " << seconds << " seconds, ";
+    cout << (unsigned long) (tokens / seconds) << " tokens/sec" << endl;
+    return 0;
+}
@@ -0,0 +1,55 @@
+#!/bin/sh
+#
+# File:		nestbench.sh
+#
+# Description:	Time the compiler on statements nested to increasing
+#		depths, up to one hundred thousand, with the native stack
+#		limited to the given number of kilobytes.  The nesting
+#		cycles through blocks, if, while, for, and do statements.
+#		The time per level should stay roughly constant as the
+#		depth grows, and every run should succeed even though the
+#		stack is far too small to hold a frame per level.
+#
+# Usage:	nestbench.sh [tcc [stack]]
+#
+
+tcc=${1:-./tcc}
+stack=${2:-256}
+
+input=`mktemp`
+trap 'rm -f "$input"' 0
+
+for depth in 1000 10000 100000; do
+    awk -v depth=$depth 'BEGIN {
+	print "int a, b;"
+	print "int main(void) {"
+
+	for (i = 0; i < depth; i ++) {
+	    kind = i % 5
+	    if (kind == 0) print "{"
+	    else if (kind == 1) print "if (a < b)"
+	    else if (kind == 2) print "while (a)"
+	    else if (kind == 3) print "for (a = 0; a < b; a = a + 1)"
+	    else print "do"
+	}
+
+	print "a = b;"
+
+	for (i = depth - 1; i >= 0; i --) {
+	    kind = i % 5
+	    if (kind == 0) print "}"
+	    else if (kind == 4) print "while (a);"
+	}
+
+	print "}"
+    }' > "$input"
+
+    start=`date +%s%N`
+    (ulimit -s $stack; "$tcc" "$input" > /dev/null)
+    status=$?
+    stop=`date +%s%N`
+    time=`expr \( $stop - $start \) / 1000`
+
+    echo "depth $depth: `expr $time / 1000` ms," \
+	"`expr $time \* 1000 / $depth` ns/level, exit $status"
+done
@@ -0,0 +1,36 @@
+#!/bin/sh
+#
+# File:		parsebench.sh
+#
+# Description:	Time one or more builds of the compiler on an
+#		expression-dense input, which is the math.c example
+#		replicated the given number of times.  Each compiler is
+#		run three times on the same input and its best time is
+#		reported, so two builds can be compared directly.
+#
+# Usage:	parsebench.sh count tcc ...
+#
+
+dir=`dirname "$0"`
+count=$1
+shift
+
+input=`mktemp`
+trap 'rm -f "$input"' 0
+"$dir/replicate.sh" $count "$dir/../../project2/examples/legal/math.c" > "$input"
+
+for tcc in "$@"; do
+    best=
+    for run in 1 2 3; do
+	start=`date +%s%N`
+	"$tcc" "$input" > /dev/null 2>&1
+	stop=`date +%s%N`
+	time=`expr $stop - $start`
+
+	if [ -z "$best" ] || [ $time -lt $best ]; then
+	    best=$time
+	fi
+    done
+
+    echo "$tcc: `expr $best / 1000000` ms"
+done
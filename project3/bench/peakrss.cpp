@@ -0,0 +1,61 @@
+/*
+ * File:	peakrss.cpp
+ *
+ * Description:	This file contains a program that runs a command and
+ *		reports its peak resident set size and its elapsed time on
+ *		the standard error, for benchmarks that measure how much
+ *		memory the compiler needs.  The output of the command is
+ *		left alone, and its exit status is passed on.
+ *
+ *		  bench/peakrss ./tcc in > /dev/null
+ */
+
+# include <chrono>
+# include <iostream>
+# include <sys/resource.h>
+# include <sys/wait.h>
+# include <unistd.h>
+
+using namespace std;
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Run the given command and report on it.
+ */
+
+int main(int argc, char *argv[])
+{
+    struct rusage usage;
+    double seconds;
+    int status;
+    pid_t pid;
+
+
+    if (argc < 2) {
+	cerr << "usage: " << argv[0] << " command [argument ...]" << endl;
+	return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+
+    if ((pid = fork()) == 0) {
+	execvp(argv[1], argv + 1);
+	cerr << argv[0] << ": cannot run " << argv[1] << endl;
+	_exit(127);
+    }
+
+    if (pid < 0 || wait4(pid, &status, 0, &usage) < 0) {
+	cerr << argv[0] << ": cannot run " << argv[1] << endl;
+	return 1;
+    }
+
+    auto stop = chrono::steady_clock::now();
+    seconds = chrono::duration<double>(stop - start).count();
+
+    cerr << "peak RSS " << usage.ru_maxrss / 1024 << " MB, ";
+    cerr << seconds << " seconds" << endl;
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
@@ -0,0 +1,19 @@
+#!/bin/sh
+#
+# File:		replicate.sh
+#
+# Description:	Write the given number of copies of the given Tiny C
+#		source files to the standard output, for use as input to
+#		the benchmarks.
+#
+# Usage:	replicate.sh count file ...
+#
+
+count=$1
+shift
+
+i=0
+while [ $i -lt $count ]; do
+    cat "$@"
+    i=`expr $i + 1`
+done
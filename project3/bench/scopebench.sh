@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# File:		scopebench.sh
+#
+# Description:	Time the compiler on increasing numbers of symbols, up to
+#		one hundred thousand, declared either as globals or as the
+#		locals of a single function.  Each symbol is declared and
+#		then assigned once, so every declaration and every use
+#		looks up a name.  The time per symbol should stay roughly
+#		constant as the number of symbols grows.
+#
+# Usage:	scopebench.sh [tcc]
+#
+
+tcc=${1:-./tcc}
+
+input=`mktemp`
+trap 'rm -f "$input"' 0
+
+for kind in global local; do
+    for count in 1000 10000 100000; do
+	awk -v count=$count -v kind=$kind 'BEGIN {
+	    if (kind == "global")
+		for (i = 0; i < count; i ++) print "int symbol" i ";"
+
+	    print "int main(void) {"
+
+	    if (kind == "local")
+		for (i = 0; i < count; i ++) print "int symbol" i ";"
+
+	    for (i = 0; i < count; i ++)
+		print "symbol" i " = symbol" (count - 1 - i) ";"
+
+	    print "}"
+	}' > "$input"
+
+	start=`date +%s%N`
+	"$tcc" "$input" > /dev/null
+	status=$?
+	stop=`date +%s%N`
+	time=`expr \( $stop - $start \) / 1000`
+
+	echo "$count ${kind}s: `expr $time / 1000` ms," \
+	    "`expr $time \* 1000 / $count` ns/symbol, exit $status"
+    done
+done
@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# File:		streambench.sh
+#
+# Description:	Report the peak memory of one or more builds of the
+#		compiler on synthetic inputs of increasing size, up to
+#		several gigabytes.  Every input is made of the same
+#		function of about a megabyte, repeated under a new name,
+#		so the largest function stays the same as the input grows.
+#		The peak memory should therefore stay roughly the same as
+#		well.  The inputs are written to the given directory, and
+#		removed afterwards.
+#
+# Usage:	streambench.sh directory tcc ...
+#
+
+dir=`dirname "$0"`
+tmp=$1
+shift
+
+input="$tmp/streambench.$$.c"
+trap 'rm -f "$input"' 0
+
+for megabytes in 256 1024 3072; do
+    awk -v count=$megabytes 'BEGIN {
+	body = "int i; int s;\n  i = 0;\n  s = 0;\n"
+
+	for (i = 0; i < 32768; i ++)
+	    body = body "  s = s + a[i] * " i % 100 " - (i + n) / 3;\n"
+
+	for (i = 0; i < count; i ++)
+	    printf "int f%d(int a[], int n) {\n  %s  return s;\n}\n\n", i, body
+    }' > "$input"
+
+    echo "`expr $(wc -c < "$input") / 1048576` MB:"
+
+    for tcc in "$@"; do
+	printf "    %s: " "$tcc"
+	"$dir/peakrss" "$tcc" "$input" 2>&1 > /dev/null
+    done
+done
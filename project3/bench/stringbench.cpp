@@ -0,0 +1,199 @@
+/*
+ * File:	stringbench.cpp
+ *
+ * Description:	This file contains a microbenchmark for parsing and
+ *		escaping strings.  Each function is run over a long string
+ *		with no escapes and over a string that is mostly escapes,
+ *		and its throughput is reported next to that of the
+ *		original character-at-a-time version, which is kept here
+ *		only for comparison.  The results of the two versions are
+ *		also checked against each other.
+ *
+ *		  bench/stringbench [kilobytes]
+ */
+
+# include <chrono>
+# include <climits>
+# include <cstdio>
+# include <cstdlib>
+# include <iostream>
+# include "../string.h"
+
+using namespace std;
+
+static volatile size_t sink;
+
+
+/*
+ * Function:	referenceParse
+ *
+ * Description:	The original version of parseString, less the detection
+ *		of invalid escape sequences and overflow.
+ */
+
+static string referenceParse(string_view s)
+{
+    unsigned start, val;
+    string result;
+
+
+    for (unsigned i = 0; i < s.size(); i ++) {
+	if (s[i] == '\\' && i + 1 < s.size()) {
+	    i ++;
+
+	    switch(s[i]) {
+	    case 'a': result += '\a'; break;
+	    case 'b': result += '\b'; break;
+	    case 'f': result += '\f'; break;
+	    case 'n': result += '\n'; break;
+	    case 'r': result += '\r'; break;
+	    case 't': result += '\t'; break;
+	    case 'v': result += '\v'; break;
+
+	    case 'x':
+		val = 0;
+		start = i;
+
+		while (i + 1 < s.size() && isxdigit(s[i + 1])) {
+		    i ++;
+		    val = val * 16 + (isdigit(s[i]) ? s[i] - '0'
+			    : tolower(s[i]) - 'a' + 10);
+		}
+
+		result += (char) (start == i ? 'x' : val);
+		break;
+
+	    case '0': case '1': case '2': case '3':
+	    case '4': case '5': case '6': case '7':
+		val = s[i] - '0';
+
+		if (i + 1 < s.size() && s[i + 1] >= '0' && s[i + 1] <= '7')
+		    val = val * 8 + (s[++ i] - '0');
+
+		if (i + 1 < s.size() && s[i + 1] >= '0' && s[i + 1] <= '7')
+		    val = val * 8 + (s[++ i] - '0');
+
+		result += (char) val;
+		break;
+
+	    default:
+		result += s[i];
+		break;
+	    }
+
+	} else
+	    result += s[i];
+    }
+
+    return result;
+}
+
+
+/*
+ * Function:	referenceEscape
+ *
+ * Description:	The original version of escapeString.
+ */
+
+static string referenceEscape(string_view s)
+{
+    char buf[5];
+    string result;
+
+
+    for (unsigned i = 0; i < s.size(); i ++)
+	if (!isprint(s[i])) {
+	    sprintf(buf, "\\%o", (unsigned char) s[i]);
+	    result += buf;
+	} else
+	    result += s[i];
+
+    return result;
+}
+
+
+/*
+ * Function:	measure
+ *
+ * Description:	Run the given function over the input repeatedly and
+ *		report its throughput in megabytes of input per second.
+ */
+
+template<class F>
+static double measure(const string &input, unsigned repeat, F f)
+{
+    double seconds;
+
+
+    auto start = chrono::steady_clock::now();
+
+    for (unsigned i = 0; i < repeat; i ++)
+	sink = f(input).size();
+
+    auto stop = chrono::steady_clock::now();
+    seconds = chrono::duration<double>(stop - start).count();
+    return input.size() * (double) repeat / seconds / 1e6;
+}
+
+
+/*
+ * Function:	compare
+ *
+ * Description:	Check and compare the two versions of one function over
+ *		the given input.
+ */
+
+template<class F, class G>
+static void compare(const char *name, const string &input, F current,
+	G reference)
+{
+    unsigned repeat;
+
+
+    if (current(input) != reference(input)) {
+	cerr << name << ": results differ" << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    repeat = (64 << 20) / input.size() + 1;
+    cout << name << ": " << measure(input, repeat, current) << " MB/s, ";
+    cout << "reference " << measure(input, repeat, reference) << " MB/s";
+    cout << endl;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Build the inputs and run the benchmark.
+ */
+
+int main(int argc, char *argv[])
+{
+    static const char text[] = "printf(\"%d %d\", x, y); /* clean */ ";
+    static const char escapes[] = "\\n\\t\\x41\\101\\\\\\\"";
+    static const char controls[] = "a\tb\nc\001d\377";
+    string clean, parse, escape;
+    unsigned size;
+
+
+    size = (argc > 1 ? atoi(argv[1]) : 16) * 1024;
+
+    while (clean.size() < size)
+	clean += text;
+
+    while (parse.size() < size)
+	parse += escapes;
+
+    while (escape.size() < size)
+	escape += controls;
+
+    auto parseOne = [](const string &s) { return parseString(s); };
+    auto escapeOne = [](const string &s) { return escapeString(s); };
+
+    compare("parse long", clean, parseOne, referenceParse);
+    compare("parse dense", parse, parseOne, referenceParse);
+    compare("escape long", clean, escapeOne, referenceEscape);
+    compare("escape dense", escape, escapeOne, referenceEscape);
+    return 0;
+}
@@ -1,66 +1,123 @@
 /*
  * File:	checker.cpp
  *
- * Description:	This file contains the public and private function and
- *		variable definitions for the semantic checker for Tiny C.
+ * Description:	This file contains the member function definitions for
+ *		the semantic checker for Tiny C.
  */
 
 # include <vector>
 # include <cassert>
-# include "lexer.h"
 # include "tokens.h"
 # include "checker.h"
 
-# define SYM_TOKEN (current == globals ? GLOBAL : LOCAL)
+# define SYM_TOKEN (_current == _context.globals ? GLOBAL : LOCAL)
 
 
 using namespace std;
 
-static Scope *globals, *current;
+
+/*
+ * Function:	Checker::Checker (constructor)
+ *
+ * Description:	Initialize this checker for the given compilation, with
+ *		its diagnostics written to the given stream.  There is no
+ *		top-level scope until one is created.
+ */
+
+Checker::Checker(CompilationContext &context, ostream &stream)
+    : _context(context), _reporter(context, stream), _current(nullptr)
+{
+}
 
 
 /*
- * Function:	initializeScope
+ * Function:	Checker::initializeScope
  *
  * Description:	Create a new scope and make it the new top-level scope.
- *		The new scope is returned for convenience.
+ *		The global scope is allocated in the arena of the
+ *		compilation, and any other scope in the arena of its
+ *		function.  The new scope is returned for convenience.
  */
 
-Scope *initializeScope()
+Scope *Checker::initializeScope()
 {
-    current = new Scope(current);
+    Arena &arena = _current == nullptr ? _context.arena : _locals;
 
-    if (globals == nullptr)
-	globals = current;
 
-    return current;
+    _current = new (arena) Scope(arena, _current);
+
+    if (_context.globals == nullptr)
+	_context.globals = _current;
+
+    return _current;
 }
 
 
 /*
- * Function:	finalizeScope
+ * Function:	Checker::finalizeScope
  *
  * Description:	Remove the top-level scope, and make its enclosing scope
- *		the new top-level scope.  The old top-level scope is
- *		returned for convenience.
+ *		the new top-level scope.  If that was the scope of a
+ *		function, then everything local to the function, its
+ *		tree included, is freed at once.
  */
 
-Scope *finalizeScope()
+void Checker::finalizeScope()
 {
-    Scope *old;
+    assert(_current != nullptr);
 
+    _current = _current->enclosing();
 
-    assert(current != nullptr);
+    if (_current == _context.globals) {
+	_locals.reset();
+	_tree.clear();
+    }
+}
 
-    old = current;
-    current = current->enclosing();
 
-    return old;
+/*
+ * Function:	Checker::reopenScope
+ *
+ * Description:	Make the given scope, which must be enclosed directly by
+ *		the global scope, the new top-level scope again.  Since
+ *		each thread has its own top-level scope, a function body
+ *		may be reopened on any thread.  The scope is returned for
+ *		convenience.
+ */
+
+Scope *Checker::reopenScope(Scope *scope)
+{
+    assert(scope->enclosing() == _context.globals);
+
+    _current = scope;
+    return _current;
 }
 
 
 /*
- * Function:	insertName
+ * Function:	Checker::declare (private)
+ *
+ * Description:	Create a symbol with the given name, type, and kind, and
+ *		insert it into the given scope.  The symbol is allocated in
+ *		the same arena as the scope, and keeps only the atom of its
+ *		name, so nothing is copied.
+ */
+
+Symbol *Checker::declare(Scope *scope, Atom name, const Type &type, int kind)
+{
+    Arena &arena = scope == _context.globals ? _context.arena : _locals;
+    Symbol *symbol;
+
+
+    symbol = new (arena) Symbol(name, type, kind);
+    scope->insert(symbol);
+
+    return symbol;
+}
+
+
+/*
+ * Function:	Checker::insertName
  *
  * Description:	Insert (i.e., declare) in the current scope a symbol with
  *		the given name and type.  If a symbol with that name
@@ -68,42 +125,39 @@ Scope *finalizeScope()
  *		redeclaration.
  */
 
-Symbol *insertName(const string &name, const Type &type)
+Symbol *Checker::insertName(const Token &name, const Type &type)
 {
     Symbol *symbol;
 
 
-    assert(current != nullptr);
-    symbol = current->find(name);
+    assert(_current != nullptr);
+    symbol = _current->find(name.atom);
 
     if (symbol != nullptr) {
-	report("'%s' redeclared", name);
+	_reporter.report(name, "'%s' redeclared", name.atom);
 	return symbol;
     }
 
-    symbol = new Symbol(name, type, SYM_TOKEN);
-    current->insert(symbol);
-
-    return symbol;
+    return declare(_current, name.atom, type, SYM_TOKEN);
 }
 
 
 /*
- * Function:	lookupName
+ * Function:	Checker::lookupName
  *
  * Description:	Lookup and return the nearest symbol with the given name.
  *		No error is reported if no such symbol is found.
  */
 
-Symbol *lookupName(const string &name)
+Symbol *Checker::lookupName(Atom name)
 {
-    assert(current != nullptr);
-    return current->lookup(name);
+    assert(_current != nullptr);
+    return _current->lookup(name);
 }
 
 
 /*
- * Function:	lookupArray
+ * Function:	Checker::lookupArray
  *
  * Description:	Lookup and return the symbol with the given name and ensure
  *		that it has an array type.  If no such symbol exists,
@@ -111,56 +165,82 @@ Symbol *lookupName(const string &name)
  *		errors.
  */
 
-Symbol *lookupArray(const string &name)
+Symbol *Checker::lookupArray(const Token &name)
 {
     Symbol *symbol;
 
 
-    assert(current != nullptr);
-    symbol = current->lookup(name);
+    assert(_current != nullptr);
+    symbol = _current->lookup(name.atom);
 
     if (symbol == nullptr) {
-	report("'%s' undeclared", name);
-	symbol = new Symbol(name, Type(INT, 1), SYM_TOKEN);
-	current->insert(symbol);
+	_reporter.report(name, "'%s' undeclared", name.atom);
+	symbol = declare(_current, name.atom, _context.types.array(INT, 1),
+	    SYM_TOKEN);
 
     } else if (!symbol->type().isArray())
-	report("array type required for '%s'", name);
+	_reporter.report(name, "array type required for '%s'", name.atom);
 
     return symbol;
 }
 
 
 /*
- * Function:	lookupFunction
+ * Function:	Checker::lookupFunction
  *
  * Description:	Lookup and return the symbol with the given name and ensure
  *		that it has a function type.  If no such symbol exists,
  *		do not report an error but instead insert an implicit
- *		function declaration in the global scope.
+ *		function declaration in the global scope.  A body parsed
+ *		lazily sees only the globals declared before it, so an
+ *		implicit declaration it made itself is found by searching
+ *		the whole global scope before declaring another one.
  */
 
-Symbol *lookupFunction(const string &name)
+Symbol *Checker::lookupFunction(const Token &name)
 {
     Symbol *symbol;
 
 
-    assert(current != nullptr);
-    symbol = current->lookup(name);
+    assert(_current != nullptr);
+    symbol = _current->lookup(name.atom);
+
+    if (symbol == nullptr)
+	symbol = _context.globals->find(name.atom);
 
     if (symbol == nullptr) {
-	symbol = new Symbol(name, Type(INT, nullptr), SYM_TOKEN);
-	globals->insert(symbol);
+	symbol = declare(_context.globals, name.atom,
+	    _context.types.function(INT, nullptr), GLOBAL);
 
     } else if (!symbol->type().isFunction())
-	report("function type required for '%s'", name);
+	_reporter.report(name, "function type required for '%s'", name.atom);
 
     return symbol;
 }
 
 
 /*
- * Function:	lookupScalar
+ * Function:	Checker::declareFunction
+ *
+ * Description:	Insert an implicit function declaration in the global
+ *		scope for the given name, as lookupFunction would, but
+ *		without reporting any errors.  Declaring ahead of time
+ *		every function that might be called leaves the global
+ *		scope unchanged while function bodies are being checked.
+ */
+
+void Checker::declareFunction(Atom name)
+{
+    assert(_current != nullptr);
+
+    if (_current->lookup(name) == nullptr)
+	declare(_context.globals, name, _context.types.function(INT, nullptr),
+	    GLOBAL);
+}
+
+
+/*
+ * Function:	Checker::lookupScalar
  *
  * Description:	Lookup and return the symbol with the given name and ensure
  *		that it has a scalar type.  If no such symbol exists,
@@ -168,39 +248,38 @@ Symbol *lookupFunction(const string &name)
  *		errors.
  */
 
-Symbol *lookupScalar(const string &name)
+Symbol *Checker::lookupScalar(const Token &name)
 {
     Symbol *symbol;
 
 
-    assert(current != nullptr);
-    symbol = current->lookup(name);
+    assert(_current != nullptr);
+    symbol = _current->lookup(name.atom);
 
     if (symbol == nullptr) {
-	report("'%s' undeclared", name);
-	symbol = new Symbol(name, Type(INT), SYM_TOKEN);
-	current->insert(symbol);
+	_reporter.report(name, "'%s' undeclared", name.atom);
+	symbol = declare(_current, name.atom, Type(INT), SYM_TOKEN);
 
     } else if (!symbol->type().isScalar())
-	report("scalar type required for '%s'", name);
+	_reporter.report(name, "scalar type required for '%s'", name.atom);
 
     return symbol;
 }
 
 
 /*
- * Function:	checkArray
+ * Function:	Checker::checkArray
  */
 
-void checkArray(Symbol *symbol)
+void Checker::checkArray(Symbol *symbol)
 {
-    if (symbol->type().isArray() && symbol->type().length() == 0)
-	report("'%s' has zero length", symbol->name());
+    if (symbol->type().isPointer())
+	_reporter.report("'%s' has zero length", symbol->atom());
 }
 
 
 /*
- * Function:	checkCall
+ * Function:	Checker::checkCall
  *
  * Description:	Check the arguments in a function call expression.  If the
  *		symbol does not have a function type, no error is reported.
@@ -208,34 +287,38 @@ void checkArray(Symbol *symbol)
  *		can be performed.  Otherwise, the number of formals and
  *		actuals must agree, the individual declarators must agree,
  *		the actual cannot have a function type, and in the case of
- *		arrays, the specifiers must agree.
+ *		arrays, the specifiers must agree.  Any error is reported
+ *		at the given name of the function.
  */
 
-Node *checkCall(Node *expr)
+Node Checker::checkCall(Node expr, const Token &name)
 {
     Symbol *symbol;
-    Types *formals;
+    const Types *formals;
+    Node arg;
     unsigned i;
 
 
-    assert(expr->token() == FUNC || expr->token() == PROC);
-    symbol = expr->kids(0)->symbol();
+    assert(_tree.token(expr) == FUNC || _tree.token(expr) == PROC);
+    symbol = _tree.symbol(_tree.first(expr));
 
     if (!symbol->type().isFunction())
 	return expr;
 
-    formals = symbol->type().parameters();
+    formals = _context.types.parameters(symbol->type());
 
     if (formals == nullptr)
 	return expr;
 
-    if (formals->size() != expr->kids().size() - 1) {
-	report("invalid arguments to '%s'", symbol->name());
+    if (formals->size() != _tree.children(expr) - 1) {
+	_reporter.report(name, "invalid arguments to '%s'", symbol->atom());
 	return expr;
     }
 
-    for (i = 0; i < formals->size(); i ++) {
-	Type actual = expr->kids(i + 1)->type();
+    arg = _tree.next(_tree.first(expr));
+
+    for (i = 0; i < formals->size(); i ++, arg = _tree.next(arg)) {
+	Type actual = _tree.type(arg);
 	Type formal = formals->at(i);
 
 	if (actual.isFunction() || (actual.isScalar() && !formal.isScalar()))
@@ -250,7 +333,26 @@ Node *checkCall(Node *expr)
     }
 
     if (i != formals->size())
-	report("invalid arguments to '%s'", symbol->name());
+	_reporter.report(name, "invalid arguments to '%s'", symbol->atom());
+
+    return expr;
+}
+
+
+/*
+ * Function:	Checker::promote
+ *
+ * Description:	Finish the type of an expression used as a value: an
+ *		expression with a char specifier is widened to int.  The
+ *		expression should be a scalar, but if it is not, an error
+ *		has already been reported when its name was looked up, and
+ *		we widen it anyway.
+ */
+
+Node Checker::promote(Node expr)
+{
+    if (_tree.type(expr).specifier() == CHAR)
+	expr = _tree.node(INT, expr);
 
     return expr;
 }
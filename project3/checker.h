@@ -1,26 +1,57 @@
 /*
  * File:	checker.h
  *
- * Description:	This file contains the public function declarations for the
- *		semantic checker for Tiny C.
+ * Description:	This file contains the class definition for the semantic
+ *		checker for Tiny C.  A checker keeps the current scope and
+ *		reports errors for one thread of a compilation, each at
+ *		the token for the name it is about, if there is one.  All
+ *		threads share the global scope of the compilation.  The
+ *		checker also keeps the arena of the function being
+ *		checked, which holds its scope and its symbols, and the
+ *		tree of the function.
  */
 
 # ifndef CHECKER_H
 # define CHECKER_H
-# include "Node.h"
+# include <ostream>
+# include "Arena.h"
+# include "CompilationContext.h"
+# include "Reporter.h"
 # include "Scope.h"
+# include "Tree.h"
 
-Scope *initializeScope();
-Scope *finalizeScope();
+class Checker {
+protected:
+    typedef std::string_view string_view;
 
-Symbol *insertName(const std::string &name, const Type &type);
+    CompilationContext &_context;
+    Reporter _reporter;
+    Scope *_current;
+    Arena _locals;
+    Tree _tree;
 
-Symbol *lookupName(const std::string &name);
-Symbol *lookupArray(const std::string &name);
-Symbol *lookupFunction(const std::string &name);
-Symbol *lookupScalar(const std::string &name);
+private:
+    Symbol *declare(Scope *scope, Atom name, const Type &type, int kind);
 
-void checkArray(Symbol *symbol);
-Node *checkCall(Node *expr);
+public:
+    Checker(CompilationContext &context, std::ostream &stream);
+
+    Scope *initializeScope();
+    void finalizeScope();
+    Scope *reopenScope(Scope *scope);
+
+    Symbol *insertName(const Token &name, const Type &type);
+
+    Symbol *lookupName(Atom name);
+    Symbol *lookupArray(const Token &name);
+    Symbol *lookupFunction(const Token &name);
+    Symbol *lookupScalar(const Token &name);
+
+    void declareFunction(Atom name);
+
+    void checkArray(Symbol *symbol);
+    Node checkCall(Node expr, const Token &name);
+    Node promote(Node expr);
+};
 
 # endif /* CHECKER_H */
@@ -0,0 +1,382 @@
+/*
+ * File:	driver.cpp
+ *
+ * Description:	This file contains the main program for Tiny C, which
+ *		handles the command line and runs the compilations.
+ *
+ *		Given a single file, or none at all, we compile it just as
+ *		we always have, writing straight to the standard output
+ *		and error.  Given several files or a directory, we compile
+ *		each file as a task on a pool of threads.  The output and
+ *		diagnostics of each file are buffered and written out in
+ *		the order the files were named, as soon as all the files
+ *		before it are done, so nothing is ever interleaved.  Each
+ *		diagnostic is then prefixed with the name of its file.
+ *
+ *		With --server, we instead run as a compile server.  With
+ *		--client, we send each source to the server and write out
+ *		what it sends back, so the command line is the same
+ *		either way.  Either may be given the path of the socket,
+ *		as in --server=path.
+ */
+
+# include <algorithm>
+# include <cstdlib>
+# include <cstring>
+# include <filesystem>
+# include <future>
+# include <iostream>
+# include <sstream>
+# include <string>
+# include <vector>
+# include <unistd.h>
+# include "CompilationContext.h"
+# include "Source.h"
+# include "ThreadPool.h"
+# include "parser.h"
+# include "server.h"
+# include "string.h"
+
+using namespace std;
+
+struct Result {
+    string output, errors;
+    bool failed;
+    promise<void> done;
+};
+
+
+/*
+ * Function:	usage
+ *
+ * Description:	Report the correct usage of the program and exit.
+ */
+
+static void usage(const char *program)
+{
+    cerr << "usage: " << program << " [-fpipeline] [-fshow-column]";
+    cerr << " [-flazy] [-fexport=name,...] [-ferror-limit=N] [-fimage]";
+    cerr << " [-fdiagnostics-format=text|json] [-fdiagnostics-dedup]";
+    cerr << " [-j N]";
+    cerr << " [--server[=socket]]";
+    cerr << " [--client[=socket]] [file|directory ...]" << endl;
+    exit(EXIT_FAILURE);
+}
+
+
+/*
+ * Function:	collect
+ *
+ * Description:	Add the named file to the list of files to compile.  If
+ *		it is a directory, add every file within it whose name
+ *		ends in .c instead, in sorted order so that the output is
+ *		always the same.  Return whether it is a directory.
+ */
+
+static bool collect(const char *path, vector<string> &files)
+{
+    namespace fs = std::filesystem;
+    vector<string> found;
+    error_code error;
+
+
+    if (!fs::is_directory(path, error)) {
+	files.push_back(path);
+	return false;
+    }
+
+    for (const auto &entry : fs::recursive_directory_iterator(path, error))
+	if (entry.is_regular_file() && entry.path().extension() == ".c")
+	    found.push_back(entry.path().string());
+
+    sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+    return true;
+}
+
+
+/*
+ * Function:	compileFile
+ *
+ * Description:	Compile the named file into the given result.  This is
+ *		the body of each task.  The result is always marked done,
+ *		even if the compilation throws, since the results are
+ *		written out in order and all those after it would
+ *		otherwise wait forever.  What the file wrote before it
+ *		failed is then dropped for just the reason it failed.
+ */
+
+static void compileFile(const string &path, const Options &options,
+	Result &result)
+{
+    ostringstream output, errors;
+    Source source;
+
+
+    try {
+	if (!source.open(path.c_str())) {
+	    errors << "cannot open file" << endl;
+	    result.failed = true;
+
+	} else {
+	    CompilationContext context(source, options, output, errors);
+	    result.failed = !compile(context);
+	}
+
+	result.output = output.str();
+	result.errors = errors.str();
+
+    } catch (const exception &error) {
+	result.errors = string("cannot compile file: ") + error.what() + "\n";
+	result.failed = true;
+
+    } catch (...) {
+	result.errors = "cannot compile file\n";
+	result.failed = true;
+    }
+
+    result.done.set_value();
+}
+
+
+/*
+ * Function:	emit
+ *
+ * Description:	Write out the result for the named file, prefixing each
+ *		diagnostic with the name, and then free its buffers.  A
+ *		diagnostic written as a JSON object instead gets the name
+ *		as its first member.
+ */
+
+static void emit(const string &path, Result &result)
+{
+    size_t start, end;
+
+
+    for (start = 0; start < result.errors.size(); start = end + 1) {
+	end = result.errors.find('\n', start);
+
+	if (end == string::npos)
+	    end = result.errors.size();
+
+	if (result.errors[start] == '{') {
+	    cerr << "{\"file\":" << quoteJSON(path) << ",";
+	    cerr << result.errors.substr(start + 1, end - start - 1);
+	} else
+	    cerr << path << ": " << result.errors.substr(start, end - start);
+
+	cerr << '\n';
+    }
+
+    cout << result.output << flush;
+    string().swap(result.output);
+    string().swap(result.errors);
+}
+
+
+/*
+ * Function:	compileRemote
+ *
+ * Description:	Compile the given source on the server at the other end
+ *		of the given connection into the given result.  Losing the
+ *		server is fatal.
+ */
+
+static void compileRemote(int fd, const vector<string> &args,
+	const Source &source, Result &result)
+{
+    string_view text(source.begin(), source.size());
+    Reply reply;
+
+
+    if (!request(fd, args, text, reply)) {
+	cerr << "lost connection to server" << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    result.output = move(reply.output);
+    result.errors = move(reply.errors);
+    result.failed = reply.status != EXIT_SUCCESS;
+}
+
+
+/*
+ * Function:	compileFiles
+ *
+ * Description:	Compile the named files on a pool of threads, and write
+ *		out the results in order.  Each file is compiled on one
+ *		thread, since there are already enough files to keep the
+ *		threads busy.  Return whether every file compiled without
+ *		any syntax errors.
+ */
+
+static bool compileFiles(const vector<string> &files, const Options &options)
+{
+    ThreadPool pool(max(options.threads, 1U));
+    vector<Result> results(files.size());
+    Options serial = options;
+    bool succeeded = true;
+
+
+    serial.threads = 0;
+
+    for (size_t i = 0; i < files.size(); i ++)
+	pool.submit([&files, &serial, &results, i]() {
+	    compileFile(files[i], serial, results[i]);
+	});
+
+    for (size_t i = 0; i < files.size(); i ++) {
+	results[i].done.get_future().wait();
+	emit(files[i], results[i]);
+
+	if (results[i].failed)
+	    succeeded = false;
+    }
+
+    return succeeded;
+}
+
+
+/*
+ * Function:	compileClient
+ *
+ * Description:	Compile the named files, or the standard input if there
+ *		are none, on the server listening on the given socket.
+ *		The files are sent one at a time over a single connection,
+ *		since the server does the work.  Return whether every file
+ *		compiled without any syntax errors.
+ */
+
+static bool compileClient(const string &path, const vector<string> &args,
+	const vector<string> &files, bool directory)
+{
+    bool succeeded = true;
+    Result result;
+    int fd;
+
+
+    if ((fd = connectServer(path)) < 0) {
+	cerr << path << ": cannot connect to server" << endl;
+	return false;
+    }
+
+    if (files.empty()) {
+	Source source;
+
+	source.open(STDIN_FILENO);
+	compileRemote(fd, args, source, result);
+	cerr << result.errors;
+	cout << result.output;
+	close(fd);
+	return !result.failed;
+    }
+
+    for (const auto &file : files) {
+	Source source;
+
+	if (!source.open(file.c_str())) {
+	    result.output.clear();
+	    result.errors = "cannot open file\n";
+	    result.failed = true;
+
+	    if (files.size() == 1 && !directory)
+		result.errors = "cannot open " + file + "\n";
+	} else
+	    compileRemote(fd, args, source, result);
+
+	if (files.size() > 1 || directory)
+	    emit(file, result);
+	else {
+	    cerr << result.errors;
+	    cout << result.output;
+	}
+
+	if (result.failed)
+	    succeeded = false;
+    }
+
+    close(fd);
+    return succeeded;
+}
+
+
+/*
+ * Function:	main
+ *
+ * Description:	Analyze the named source files, or the standard input
+ *		stream if no file is named.  A named file is mapped into
+ *		memory rather than read.  With -fpipeline, the lexer runs
+ *		on its own thread ahead of the parser.  With -fshow-column,
+ *		diagnostics include the column as well as the line.  With
+ *		-flazy, only function bodies reachable from main are
+ *		parsed, and -fexport=name,... names further functions to
+ *		start from.  With -ferror-limit=N, we recover from syntax
+ *		errors and give up only after N of them, rather than at
+ *		the first, and write no more than N diagnostics.  With
+ *		-fdiagnostics-format=json, each diagnostic is a JSON
+ *		object on a line of its own.  With -fdiagnostics-dedup,
+ *		a message about a symbol is reported only once in a file.
+ *		With -fimage, the output is a binary image of the trees
+ *		and symbols rather than text.  With -j N, N threads are
+ *		used: for the files if there are several, or else for the
+ *		function bodies of the one file.  Lazy parsing is always
+ *		done on one thread.  We fail if any file fails.
+ */
+
+int main(int argc, char *argv[])
+{
+    vector<string> args, operands, files;
+    bool server = false, client = false;
+    bool directory = false;
+    string socket = socketPath();
+    Options options;
+    Source source;
+
+
+    for (int i = 1; i < argc; i ++) {
+	if (strcmp(argv[i], "--server") == 0)
+	    server = true;
+	else if (strncmp(argv[i], "--server=", 9) == 0) {
+	    server = true;
+	    socket = argv[i] + 9;
+	} else if (strcmp(argv[i], "--client") == 0)
+	    client = true;
+	else if (strncmp(argv[i], "--client=", 9) == 0) {
+	    client = true;
+	    socket = argv[i] + 9;
+	} else
+	    args.push_back(argv[i]);
+    }
+
+    if (!options.parse(args, operands) || (server && client))
+	usage(argv[0]);
+
+    if (server)
+	return serve(socket, options.threads > 0 ? options.threads
+		: thread::hardware_concurrency());
+
+    for (const auto &operand : operands)
+	if (collect(operand.c_str(), files))
+	    directory = true;
+
+    if (client) {
+	if (!compileClient(socket, args, files, directory))
+	    return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+    }
+
+    if (files.size() > 1 || directory)
+	return compileFiles(files, options) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (files.empty())
+	source.open(STDIN_FILENO);
+
+    else if (!source.open(files[0].c_str())) {
+	cerr << argv[0] << ": cannot open " << files[0] << endl;
+	exit(EXIT_FAILURE);
+    }
+
+    CompilationContext context(source, options, cout, cerr);
+    return compile(context) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,301 @@
+/*
+ * File:	image.cpp
+ *
+ * Description:	This file contains the member function definitions for
+ *		writing binary images of compilations in Tiny C.
+ *
+ *		To make a section, we collect its records in vectors that
+ *		the writer keeps from one section to the next, giving each
+ *		symbol and type its index the first time it is seen, and
+ *		then lay them out one after another in a single string.
+ *		Every record is a multiple of four bytes, and the
+ *		characters are padded to a multiple of eight, so every
+ *		array in an image is aligned for the words in it.
+ */
+
+# include <stdexcept>
+# include "Scope.h"
+# include "Tree.h"
+# include "atom.h"
+# include "image.h"
+
+using namespace std;
+
+
+/*
+ * Function:	ImageWriter::ImageWriter (constructor)
+ *
+ * Description:	Initialize this writer to have written nothing.
+ */
+
+ImageWriter::ImageWriter()
+    : _written(0)
+{
+}
+
+
+/*
+ * Function:	ImageWriter::type (private)
+ *
+ * Description:	Return the index of the given type in the current
+ *		section, adding it and the types of any parameters if it
+ *		is not already there.  An unspecified parameter list has a
+ *		count of IMAGE_NONE.
+ */
+
+uint32_t ImageWriter::type(const TypeTable &types, const Type &type)
+{
+    const Types *parameters;
+    ImageType record;
+
+
+    auto it = _types.find(type.id());
+
+    if (it != _types.end())
+	return it->second;
+
+    record = {IMAGE_SCALAR, (uint32_t) type.specifier(), 0, 0, 0};
+
+    if (type.isArray()) {
+	record.declarator = IMAGE_ARRAY;
+	record.length = types.length(type);
+
+    } else if (type.isFunction()) {
+	record.declarator = IMAGE_FUNCTION;
+	record.count = IMAGE_NONE;
+
+	if ((parameters = types.parameters(type)) != nullptr) {
+	    for (const auto &parameter : *parameters)
+		this->type(types, parameter);
+
+	    record.parameters = _parameters.size();
+	    record.count = parameters->size();
+
+	    for (const auto &parameter : *parameters)
+		_parameters.push_back(_types[parameter.id()]);
+	}
+    }
+
+    _types.emplace(type.id(), _typeRecords.size());
+    _typeRecords.push_back(record);
+    return _typeRecords.size() - 1;
+}
+
+
+/*
+ * Function:	ImageWriter::symbol (private)
+ *
+ * Description:	Return the index of the given symbol in the current
+ *		section, adding it and its type if it is not already
+ *		there.  Its name is found in the given table of atoms.
+ */
+
+uint32_t ImageWriter::symbol(const Atoms &atoms, const TypeTable &types,
+	const Symbol *symbol)
+{
+    string_view name = atoms.name(symbol->atom());
+    ImageSymbol record;
+
+
+    auto it = _symbols.find(symbol);
+
+    if (it != _symbols.end())
+	return it->second;
+
+    record.name = _chars.size();
+    record.length = name.size();
+    record.type = type(types, symbol->type());
+    record.kind = symbol->kind();
+    record.value = symbol->value();
+
+    if (symbol->kind() == STRLIT)
+	record.value = types.length(symbol->type()) - 1;
+
+    _chars.append(name);
+    _symbols.emplace(symbol, _symbolRecords.size());
+    _symbolRecords.push_back(record);
+    return _symbolRecords.size() - 1;
+}
+
+
+/*
+ * Function:	ImageWriter::section (private)
+ *
+ * Description:	Lay out the records collected so far as a section with
+ *		the given function and root, and then forget them.  The
+ *		offsets within a section are only 32 bits, so we fail
+ *		rather than write one of 4 GB or more.
+ */
+
+string ImageWriter::section(uint32_t function, uint32_t root)
+{
+    ImageSection header;
+    string result;
+    size_t size;
+
+
+    size = sizeof(ImageSection) + _symbolRecords.size() * sizeof(ImageSymbol)
+	+ _typeRecords.size() * sizeof(ImageType)
+	+ _parameters.size() * sizeof(uint32_t)
+	+ _nodes.size() * sizeof(ImageNode) + _chars.size();
+
+    if (size > UINT32_MAX - 7)
+	throw length_error("image section of 4 GB or more");
+
+    header.function = function;
+    header.root = root;
+
+    header.nsymbols = _symbolRecords.size();
+    header.symbols = sizeof(ImageSection);
+
+    header.ntypes = _typeRecords.size();
+    header.types = header.symbols + header.nsymbols * sizeof(ImageSymbol);
+
+    header.nparameters = _parameters.size();
+    header.parameters = header.types + header.ntypes * sizeof(ImageType);
+
+    header.nnodes = _nodes.size();
+    header.nodes = header.parameters + header.nparameters * sizeof(uint32_t);
+
+    header.nchars = _chars.size();
+    header.chars = header.nodes + header.nnodes * sizeof(ImageNode);
+
+    header.size = (header.chars + header.nchars + 7) & ~7U;
+
+    result.resize(header.size);
+    memcpy(&result[0], &header, sizeof(header));
+    memcpy(&result[header.symbols], _symbolRecords.data(),
+	header.nsymbols * sizeof(ImageSymbol));
+    memcpy(&result[header.types], _typeRecords.data(),
+	header.ntypes * sizeof(ImageType));
+    memcpy(&result[header.parameters], _parameters.data(),
+	header.nparameters * sizeof(uint32_t));
+    memcpy(&result[header.nodes], _nodes.data(),
+	header.nnodes * sizeof(ImageNode));
+    memcpy(&result[header.chars], _chars.data(), header.nchars);
+
+    _symbols.clear();
+    _types.clear();
+    _symbolRecords.clear();
+    _typeRecords.clear();
+    _parameters.clear();
+    _nodes.clear();
+    _chars.clear();
+
+    return result;
+}
+
+
+/*
+ * Function:	ImageWriter::function
+ *
+ * Description:	Return the section for the given function, whose tree
+ *		has the given root and whose parameters and locals are in
+ *		the given scope.
+ */
+
+string ImageWriter::function(const Atoms &atoms, const TypeTable &types,
+	const Tree &tree, uint32_t root, const Symbol *function,
+	const Scope *scope)
+{
+    const Symbol *symbol;
+    uint32_t index;
+
+
+    index = this->symbol(atoms, types, function);
+
+    for (const auto &local : scope->symbols())
+	this->symbol(atoms, types, local);
+
+    for (Node node = 0; node < tree.size(); node ++) {
+	symbol = tree.symbol(node);
+
+	_nodes.push_back({tree.token(node),
+	    symbol != nullptr ? this->symbol(atoms, types, symbol)
+		: IMAGE_NONE,
+	    tree.first(node), tree.next(node), type(types, tree.type(node))});
+    }
+
+    return section(index, root);
+}
+
+
+/*
+ * Function:	ImageWriter::globals
+ *
+ * Description:	Return the section for the global symbols in the given
+ *		scope, which has no function and no tree.
+ */
+
+string ImageWriter::globals(const Atoms &atoms, const TypeTable &types,
+	const Scope *scope)
+{
+    for (const auto &global : scope->symbols())
+	symbol(atoms, types, global);
+
+    return section(IMAGE_NONE, IMAGE_NONE);
+}
+
+
+/*
+ * Function:	ImageWriter::write (private)
+ *
+ * Description:	Write the given bytes to the given stream, starting with
+ *		the header of the image if nothing has been written yet.
+ */
+
+ostream &ImageWriter::write(ostream &ostr, const void *data, size_t size)
+{
+    ImageHeader header;
+
+
+    if (_written == 0) {
+	memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+	header.version = IMAGE_VERSION;
+	ostr.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	_written = sizeof(header);
+    }
+
+    ostr.write(static_cast<const char *>(data), size);
+    _written += size;
+    return ostr;
+}
+
+
+/*
+ * Function:	ImageWriter::write
+ *
+ * Description:	Write the given section of a function to the given
+ *		stream, noting where it was written for the index.
+ */
+
+ostream &ImageWriter::write(ostream &ostr, const string &section)
+{
+    _sections.push_back(_written == 0 ? sizeof(ImageHeader) : _written);
+    return write(ostr, section.data(), section.size());
+}
+
+
+/*
+ * Function:	ImageWriter::finish
+ *
+ * Description:	Finish the image on the given stream by writing the given
+ *		section of the global symbols, the index of the sections,
+ *		and the trailer.
+ */
+
+ostream &ImageWriter::finish(ostream &ostr, const string &globals)
+{
+    ImageTrailer trailer;
+
+
+    memcpy(trailer.magic, IMAGE_MAGIC, sizeof(trailer.magic));
+    trailer.globals = _written == 0 ? sizeof(ImageHeader) : _written;
+    write(ostr, globals.data(), globals.size());
+
+    trailer.index = _written;
+    trailer.count = _sections.size();
+    write(ostr, _sections.data(), _sections.size() * sizeof(uint64_t));
+
+    return write(ostr, &trailer, sizeof(trailer)) << flush;
+}
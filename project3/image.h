@@ -0,0 +1,249 @@
+/*
+ * File:	image.h
+ *
+ * Description:	This file contains the definition of the binary image of
+ *		a compilation in Tiny C, which holds the abstract syntax
+ *		tree of every function along with its symbols, types, and
+ *		literals.  An image is meant to be mapped into memory by
+ *		another process and walked where it lies, so it contains
+ *		no pointers, only indices and offsets, and every record is
+ *		made of 32-bit words in the byte order of the machine,
+ *		which is always little-endian, since that is all we
+ *		support.
+ *
+ *		An image starts with a header that gives its version, and
+ *		ends with a trailer that gives the offset of an index of
+ *		its sections, from the start of the image.  These offsets
+ *		of sections are 64-bit words, so that an image may be 4 GB
+ *		or more, and every section is padded to a multiple of
+ *		eight bytes so that they stay aligned.  Only a section
+ *		itself must be smaller than 4 GB.  There is a
+ *		section for each function, in the order they were defined,
+ *		and a final section for the global symbols.  A section is
+ *		self-contained: it has its own arrays of symbols, types,
+ *		nodes, and characters, at offsets from the start of the
+ *		section, and everything in it refers to everything else by
+ *		index into those arrays.  A section can therefore be read
+ *		without reading any other, or copied elsewhere whole.
+ *
+ *		The first symbol of a function section is the function
+ *		itself, followed by its parameters and locals in the order
+ *		they were declared, and then every other symbol its tree
+ *		refers to, including literals.  The kind of a symbol and
+ *		the specifier of a type are given by their tokens, as in
+ *		tokens.h.  An integer literal also has its value, and a
+ *		string literal the length of its string.  The nodes are
+ *		those of the tree, with the same token, children, and type,
+ *		and the root is given by the section.
+ *
+ *		An Image is a view of an image that lies in memory, such as
+ *		one mapped from a file, and is defined entirely here, so
+ *		that any program may read an image just by including this
+ *		file.  Writing an image needs the rest of the compiler.
+ *		The writer makes each section as a string of its own, so
+ *		that a section can be made on any thread and kept until it
+ *		is time to write it out, and it keeps track of where each
+ *		section was written.
+ */
+
+# ifndef IMAGE_H
+# define IMAGE_H
+# include <cstddef>
+# include <cstdint>
+# include <cstring>
+# include <ostream>
+# include <string>
+# include <string_view>
+# include <unordered_map>
+# include <vector>
+
+class Atoms;
+class Scope;
+class Symbol;
+class Tree;
+class Type;
+class TypeTable;
+
+# define IMAGE_MAGIC "TCCI"
+# define IMAGE_VERSION 2
+# define IMAGE_NONE UINT32_MAX
+
+enum {
+    IMAGE_SCALAR, IMAGE_ARRAY, IMAGE_FUNCTION
+};
+
+struct ImageHeader {
+    char magic[4];
+    uint32_t version;
+};
+
+struct ImageTrailer {
+    uint64_t index, globals;
+    uint32_t count;
+    char magic[4];
+};
+
+struct ImageType {
+    uint32_t declarator, specifier, length;
+    uint32_t parameters, count;
+};
+
+struct ImageSymbol {
+    uint32_t name, length, type;
+    int32_t kind, value;
+};
+
+struct ImageNode {
+    int32_t token;
+    uint32_t symbol, first, next, type;
+};
+
+struct ImageSection {
+    uint32_t size, function, root;
+    uint32_t nsymbols, symbols, ntypes, types, nparameters, parameters;
+    uint32_t nnodes, nodes, nchars, chars;
+
+    template<class T> const T *array(uint32_t offset) const {
+	return reinterpret_cast<const T *>(
+	    reinterpret_cast<const char *>(this) + offset);
+    }
+
+    const ImageSymbol &symbol(uint32_t i) const {
+	return array<ImageSymbol>(symbols)[i];
+    }
+
+    const ImageType &type(uint32_t i) const {
+	return array<ImageType>(types)[i];
+    }
+
+    uint32_t parameter(const ImageType &type, uint32_t i) const {
+	return array<uint32_t>(parameters)[type.parameters + i];
+    }
+
+    const ImageNode &node(uint32_t i) const {
+	return array<ImageNode>(nodes)[i];
+    }
+
+    std::string_view name(const ImageSymbol &symbol) const {
+	return std::string_view(array<char>(chars) + symbol.name,
+	    symbol.length);
+    }
+};
+
+
+class Image {
+    const char *_base;
+    size_t _size;
+
+    const ImageTrailer &trailer() const {
+	return *reinterpret_cast<const ImageTrailer *>(
+	    _base + _size - sizeof(ImageTrailer));
+    }
+
+    const ImageSection &section(uint64_t offset) const {
+	return *reinterpret_cast<const ImageSection *>(_base + offset);
+    }
+
+    bool fits(uint64_t offset, size_t size) const {
+	return offset % 8 == 0 && offset <= _size && size <= _size - offset;
+    }
+
+public:
+    Image(const void *base, size_t size)
+	: _base(static_cast<const char *>(base)), _size(size) {}
+
+    bool valid() const;
+
+    uint32_t functions() const { return trailer().count; }
+
+    const ImageSection &function(uint32_t i) const {
+	return section(reinterpret_cast<const uint64_t *>(
+	    _base + trailer().index)[i]);
+    }
+
+    const ImageSection &globals() const {
+	return section(trailer().globals);
+    }
+};
+
+
+/*
+ * Function:	Image::valid
+ *
+ * Description:	Return whether this image has the right header and
+ *		trailer, and whether its index and every section it names
+ *		lie within it.  The contents of each section are trusted.
+ */
+
+inline bool Image::valid() const
+{
+    const ImageHeader *header;
+    const uint64_t *index;
+    uint64_t offset;
+
+
+    if (_size < sizeof(ImageHeader) + sizeof(ImageTrailer) || _size % 8 != 0)
+	return false;
+
+    header = reinterpret_cast<const ImageHeader *>(_base);
+
+    if (memcmp(header->magic, IMAGE_MAGIC, 4) != 0)
+	return false;
+
+    if (header->version != IMAGE_VERSION)
+	return false;
+
+    if (memcmp(trailer().magic, IMAGE_MAGIC, 4) != 0)
+	return false;
+
+    if (!fits(trailer().index, (size_t) trailer().count * sizeof(uint64_t)))
+	return false;
+
+    index = reinterpret_cast<const uint64_t *>(_base + trailer().index);
+
+    for (uint32_t i = 0; i <= trailer().count; i ++) {
+	offset = i < trailer().count ? index[i] : trailer().globals;
+
+	if (!fits(offset, sizeof(ImageSection)))
+	    return false;
+
+	if (!fits(offset, section(offset).size))
+	    return false;
+    }
+
+    return true;
+}
+
+
+class ImageWriter {
+    std::vector<uint64_t> _sections;
+    uint64_t _written;
+
+    std::unordered_map<const Symbol *, uint32_t> _symbols;
+    std::unordered_map<uint32_t, uint32_t> _types;
+    std::vector<ImageSymbol> _symbolRecords;
+    std::vector<ImageType> _typeRecords;
+    std::vector<uint32_t> _parameters;
+    std::vector<ImageNode> _nodes;
+    std::string _chars;
+
+    uint32_t type(const TypeTable &types, const Type &type);
+    uint32_t symbol(const Atoms &atoms, const TypeTable &types,
+	const Symbol *symbol);
+    std::string section(uint32_t function, uint32_t root);
+    std::ostream &write(std::ostream &ostr, const void *data, size_t size);
+
+public:
+    ImageWriter();
+
+    std::string function(const Atoms &atoms, const TypeTable &types,
+	const Tree &tree, uint32_t root, const Symbol *function,
+	const Scope *scope);
+    std::string globals(const Atoms &atoms, const TypeTable &types,
+	const Scope *scope);
+
+    std::ostream &write(std::ostream &ostr, const std::string &section);
+    std::ostream &finish(std::ostream &ostr, const std::string &globals);
+};
+
+# endif /* IMAGE_H */
@@ -1,18 +1,68 @@
 /*
  * File:	lexer.h
  *
- * Description:	This file contains the public function and variable
- *		declarations for the lexical analyzer for Tiny C.
+ * Description:	This file contains the class definitions for the lexical
+ *		analyzer for Tiny C.
+ *
+ *		A token is a compact record of its kind and its position
+ *		in the source.  The position is just a byte offset; the
+ *		line and column are worked out from it only when we emit
+ *		a diagnostic, so nobody counts lines while scanning.  The
+ *		lexer never reports errors itself, since it may be running
+ *		ahead of the parser on another thread; instead, any error
+ *		is noted in the token and reported when the parser first
+ *		looks at the token.
+ *
+ *		Identifiers are interned by the lexer, and a name carries
+ *		its atom.  Literals are decoded exactly once, by the lexer,
+ *		and the result is carried in the token.  Integer and character
+ *		literals carry their value.  A string literal without
+ *		escape sequences is its own value, so it carries nothing;
+ *		otherwise, it carries its decoded value, which is kept in
+ *		an arena by the lexer with its length as a prefix.
  */
 
 # ifndef LEXER_H
 # define LEXER_H
 # include <string>
+# include <string_view>
+# include "Arena.h"
+# include "Source.h"
+# include "atom.h"
+
+enum {
+    LEX_OK, LEX_TOO_LARGE, LEX_UNKNOWN_ESCAPE, LEX_OUT_OF_RANGE,
+    LEX_MULTI_CHARACTER
+};
+
+struct Token {
+    size_t offset;
+    unsigned length;
+    short kind, error;
+
+    union {
+	int value;
+	const char *decoded;
+	Atom atom;
+    };
+};
+
+class Lexer {
+    typedef std::string_view string_view;
+
+    const Source &_source;
+    Atoms &_atoms;
+    const char *_cursor;
+
+    Arena _literals;
 
-extern char *yytext;
-extern int yylineno, numerrors;
+    void decodeNumber(Token &token) const;
+    void decodeString(Token &token, bool escaped);
 
-int yylex();
-void report(const std::string &str, const std::string &arg = "");
+public:
+    Lexer(const Source &source, Atoms &atoms, size_t offset = 0);
+    void scan(Token &token);
+    string_view literal(const Token &token) const;
+};
 
 # endif /* LEXER_H */
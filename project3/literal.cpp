@@ -1,83 +1,198 @@
 /*
  * File:	literal.cpp
  *
- * Description:	This file contains the public and private function and
- *		variable declarations for handling integer and string
- *		literals as symbols.
+ * Description:	This file contains the member function definitions for
+ *		tables of integer and string literals in Tiny C.
+ *
+ *		Literals arrive already decoded by the lexer, so string
+ *		literals are interned by their actual value and integer
+ *		literals by their numeric value.  Nothing is parsed here,
+ *		and a string literal is escaped only when it is first
+ *		seen.  The tables keep their own copies of the keys, in
+ *		an arena along with the symbols.  The name of a literal is
+ *		interned as an atom, like that of any other symbol; it can
+ *		never be mistaken for an identifier, since it starts with a
+ *		quote or a digit.
+ *
+ *		Small integers, such as the element sizes used in every
+ *		array index, are kept in a directly mapped array.  Other
+ *		integers are kept in an open-addressing hash table with
+ *		linear probing that is never more than half full.  Either
+ *		way, each value has exactly one symbol, so equal literals
+ *		are always the same symbol.
+ *
+ *		Function bodies may be parsed on several threads at once,
+ *		in which case the tables are protected by a single lock.
+ *		A table used by only one thread never takes it.
+ *
+ *		The symbols may be hanging around in abstract syntax
+ *		trees, so they are never freed by themselves, but only
+ *		along with the arena when the compilation is done.
  */
 
-# include <unordered_map>
 # include "literal.h"
 # include "string.h"
 
 using namespace std;
-static unordered_map<string, Symbol *> literals;
 
 
 /*
- * Function:	makeLiteral
+ * Function:	Literals::Literals (constructor)
+ *
+ * Description:	Initialize this table of literals to be empty.  The names
+ *		of literals are interned in the given table of atoms, and
+ *		the types of string literals are taken from the given
+ *		table of types.  If the table is concurrent, it may be used
+ *		by several threads at once.
+ */
+
+Literals::Literals(Atoms &atoms, TypeTable &types, bool concurrent)
+    : _concurrent(concurrent), _atoms(atoms), _types(types), _small(),
+      _integers(64), _count(0)
+{
+}
+
+
+/*
+ * Function:	Literals::add (private)
  *
- * Description:	Insert a literal with the given name.  For uniformity,
- *		string, character, and integer literals are all represented
- *		as symbols; however, we only need one copy of each.  The
- *		type of the literal is inferred from its name.  A string
- *		literal is first parsed and then escaped in order to create
- *		a canonical version.
+ * Description:	Insert a string literal with the given value.  For
+ *		uniformity, string, character, and integer literals are
+ *		all represented as symbols; however, we only need one copy
+ *		of each.  The name of a string literal is its escaped
+ *		value, which gives a canonical version.
  */
 
-Symbol *makeLiteral(const string &name)
+Symbol *Literals::add(string_view value)
 {
     Symbol *symbol;
-    string parsed, escaped;
+    Atom name;
+    Type type(CHAR);
 
 
-    if (name[0] == '"') {
-	parsed = parseString(name);
-	escaped = escapeString(parsed);
-	symbol = literals[escaped];
+    auto it = _strings.find(value);
+
+    if (it != _strings.end())
+	return it->second;
+
+    name = _atoms.intern("\"" + escapeString(value) + "\"");
+    type = _types.array(CHAR, value.size() + 1);
+    symbol = new (_arena) Symbol(name, type, STRLIT);
+
+    _strings.emplace(_arena.copy(value), symbol);
+    return symbol;
+}
+
+
+/*
+ * Function:	Literals::slot (private)
+ *
+ * Description:	Return the slot in the hash table for the given integer,
+ *		which is either its slot or the empty slot where it would
+ *		go.  The multiplier scatters nearby values.
+ */
+
+Literals::Entry &Literals::slot(int value)
+{
+    unsigned mask = _integers.size() - 1;
+    unsigned h = ((unsigned) value * 2654435761U) & mask;
+
+
+    while (_integers[h].symbol != nullptr && _integers[h].value != value)
+	h = (h + 1) & mask;
+
+    return _integers[h];
+}
+
+
+/*
+ * Function:	Literals::grow (private)
+ *
+ * Description:	Double the size of the hash table and reinsert every
+ *		integer.
+ */
+
+void Literals::grow()
+{
+    vector<Entry> old(_integers.size() * 2);
 
-	if (symbol == nullptr) {
-	    symbol = new Symbol(escaped, Type(CHAR, parsed.size() + 1), STRLIT);
-	    literals[escaped] = symbol;
-	}
 
-    } else {
-	symbol = literals[name];
+    old.swap(_integers);
+
+    for (const auto &entry : old)
+	if (entry.symbol != nullptr)
+	    slot(entry.value) = entry;
+}
 
-	if (symbol == nullptr) {
-	    symbol = new Symbol(name, Type(INT), NUM);
-	    literals[name] = symbol;
+
+/*
+ * Function:	Literals::add (private)
+ *
+ * Description:	Insert an integer literal with the given value.  The
+ *		name of the literal is its value in decimal.
+ */
+
+Symbol *Literals::add(int value)
+{
+    Symbol **symbol;
+
+
+    if (value >= smallest && value <= largest)
+	symbol = &_small[value - smallest];
+
+    else {
+	Entry *entry = &slot(value);
+
+	if (entry->symbol == nullptr) {
+	    if (2 * (_count + 1) > _integers.size()) {
+		grow();
+		entry = &slot(value);
+	    }
+
+	    entry->value = value;
+	    _count ++;
 	}
+
+	symbol = &entry->symbol;
     }
 
-    return symbol;
+    if (*symbol == nullptr)
+	*symbol = new (_arena) Symbol(_atoms.intern(to_string(value)),
+	    Type(INT), NUM, value);
+
+    return *symbol;
 }
 
 
 /*
- * Function:	makeLiteral
+ * Function:	Literals::insert
  *
- * Description:	Insert an integer literal with the given value.
+ * Description:	Return the symbol for a string literal with the given
+ *		value, taking the lock if need be.
  */
 
-Symbol *makeLiteral(int value)
+Symbol *Literals::insert(string_view value)
 {
-    return makeLiteral(to_string(value));
+    if (!_concurrent)
+	return add(value);
+
+    lock_guard<mutex> guard(_lock);
+    return add(value);
 }
 
 
 /*
- * Function:	getLiterals
+ * Function:	Literals::insert
  *
- * Description:	Return a vector of all literals.
+ * Description:	Return the symbol for an integer literal with the given
+ *		value, taking the lock if need be.
  */
 
-const Symbols getLiterals()
+Symbol *Literals::insert(int value)
 {
-    Symbols all;
-
-    for (auto p : literals)
-	all.push_back(p.second);
+    if (!_concurrent)
+	return add(value);
 
-    return all;
+    lock_guard<mutex> guard(_lock);
+    return add(value);
 }
@@ -1,17 +1,55 @@
 /*
  * File:	literal.h
  *
- * Description:	This file contains the public function declarations for
- *		handling integer and string literals as symbols.
+ * Description:	This file contains the class definition for handling
+ *		integer and string literals as symbols.  Each compilation
+ *		has its own table of literals.
  */
 
 # ifndef LITERAL_H
 # define LITERAL_H
+# include <mutex>
 # include <string>
+# include <string_view>
+# include <unordered_map>
+# include <vector>
+# include "Arena.h"
 # include "Symbol.h"
+# include "atom.h"
 
-Symbol *makeLiteral(const std::string &name);
-Symbol *makeLiteral(int value);
-const Symbols getLiterals();
+class Literals {
+    typedef std::string_view string_view;
+
+    struct Entry {
+	int value;
+	Symbol *symbol;
+    };
+
+    static const int smallest = -128, largest = 1023;
+
+    bool _concurrent;
+    std::mutex _lock;
+    Atoms &_atoms;
+    TypeTable &_types;
+    Arena _arena;
+    std::unordered_map<string_view, Symbol *> _strings;
+    Symbol *_small[largest - smallest + 1];
+    std::vector<Entry> _integers;
+    unsigned _count;
+
+    Entry &slot(int value);
+    void grow();
+    Symbol *add(string_view value);
+    Symbol *add(int value);
+
+public:
+    Literals(Atoms &atoms, TypeTable &types, bool concurrent = false);
+
+    Literals(const Literals &) = delete;
+    Literals &operator =(const Literals &) = delete;
+
+    Symbol *insert(string_view value);
+    Symbol *insert(int value);
+};
 
 # endif /* LITERAL_H */
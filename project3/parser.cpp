@@ -4,88 +4,194 @@
  * Description:	This file contains the public and private function and
  *		variable definitions for the recursive-descent parser for
  *		Tiny C.
+ *
+ *		The parser keeps its position in the input, so each
+ *		thread of a compilation has its own parser.  Everything
+ *		else lives in the compilation context, and nothing is
+ *		kept in global variables, so any number of compilations
+ *		may run at once.
  */
 
 # include <string>
-# include <cstdlib>
 # include <iostream>
-# include "Node.h"
+# include <set>
+# include <sstream>
+# include <unordered_map>
+# include <unordered_set>
+# include <vector>
+# include "Tree.h"
 # include "lexer.h"
 # include "tokens.h"
-# include "string.h"
+# include "ThreadPool.h"
+# include "TokenStream.h"
 # include "checker.h"
-# include "literal.h"
+# include "image.h"
+# include "parser.h"
 
 using namespace std;
 
-static int word, peeked;
-static string lexeme;
-static Node *expression(), *statement();
+struct SyntaxError {};
+struct Abandon {};
+
+class Parser : Checker {
+  struct Body {
+    Symbol *function;
+    Scope *scope;
+    size_t offset;
+    bool required, failed;
+    string before, errors, output;
+    vector<Reporter::Key> seen;
+    Arena arena;
+  };
+
+  bool parallel;
+  int word;
+  Token current;
+  TokenStream *tokens;
+
+  unsigned syntaxerrors;
+  const char *lasterror;
+
+  vector<Body> bodies;
+  vector<size_t> required;
+  unordered_map<Symbol *, size_t> definitions;
+  ostringstream pending;
+  ImageWriter image;
+
+  int peek();
+  int nextWord();
+  void error();
+  void match(int token);
+  void synchronize();
+  void recover();
+
+  void require(Symbol *function);
+  Symbol *callee(const Token &name);
+
+  Node argument();
+  void argumentList(Node expr);
+  Node primaryExpression();
+  Node unaryExpression();
+  Node binaryExpression(int minimum);
+  Node expression();
+  Node assignment();
+  Node statements();
+  Node statement();
+
+  int specifier();
+  void parameter(Types *formals);
+  void parameterList(Types *formals);
+  void parameters(Types *formals);
+  void declarator(int typespec);
+  void moreDeclarators(int typespec);
+  void declaration();
+  void declarations();
+  Node functionBody();
+
+  void skipBody(Symbol *function, Scope *scope);
+  void parseBody(Body &body);
+  void parseReachable();
+  void parseTask(Body &body);
+  void parseParallel();
+  void globalDeclaration();
+  void emit(const string &output);
+  void finish();
+
+public:
+  Parser(CompilationContext &context, ostream &stream);
+  bool translationUnit();
+};
 
 
 /*
- * Function:	peek
+ * Function:	Parser::Parser (constructor)
  *
- * Description:	Return the next word from the lexer, but do not fetch it.
+ * Description:	Initialize this parser for the given compilation, with
+ *		its diagnostics written to the given stream.  Lazy parsing
+ *		is always done on one thread.
  */
 
-static int peek()
+Parser::Parser(CompilationContext &context, ostream &stream)
+  : Checker(context, stream),
+    parallel(context.options.threads > 0 && !context.options.lazy),
+    word(0), tokens(nullptr), syntaxerrors(0), lasterror(nullptr)
 {
-  if (peeked == 0)
-	  peeked = yylex();
+}
+
+
+/*
+ * Function:	Parser::peek
+ *
+ * Description:	Return the next word from the lexer, but do not fetch it.
+ */
 
-  return peeked;
+int Parser::peek()
+{
+  return tokens->peek().kind;
 }
 
 
 /*
- * Function:	nextWord
+ * Function:	Parser::nextWord
  *
  * Description:	Return the next word from the lexer.  The textbook calls
- *		such a function 'nextWord' and calls the text that was
- *		matched 'lexeme' so we do as well.
+ *		such a function 'nextWord' so we do as well.  Rather than
+ *		the text that was matched, we keep the whole token, since
+ *		it carries the atom of any name and the value of any
+ *		literal, so nothing is copied here.
  */
 
-static int nextWord()
+int Parser::nextWord()
 {
-  int token;
-    
-    
-  if (peeked != 0) {
-	  token = peeked;
-	  peeked = 0;
-  } 
-  else
-	  token = yylex();
-
-  lexeme = yytext;
-  return token;
+  current = tokens->next();
+  return current.kind;
 }
 
 
 /*
- * Function:	error
+ * Function:	Parser::error
  *
- * Description:	Report a syntax error to standard error.
+ * Description:	Report a syntax error and throw it back to the nearest
+ *		point at which we can recover.  A second error at the same
+ *		token is not reported again, since it is only a result of
+ *		the first.  Once the error limit is reached, we abandon
+ *		the compilation instead, which is what we have always
+ *		done at the first error by default.
+ *
+ *		When parsing in parallel, we abandon at the first error,
+ *		since what the function bodies see of each other depends
+ *		on how we recover, and the compilation is then started
+ *		over on one thread.
  */
 
-static void error()
+void Parser::error()
 {
-    cerr << "line " << yylineno;
-    cerr << ": syntax error at '" << yytext << "'" << endl;
-    exit(EXIT_FAILURE);
+  unsigned limit = _context.options.errorlimit;
+
+
+  if (_reporter.text().data() == lasterror)
+	  throw SyntaxError();
+
+  lasterror = _reporter.text().data();
+  syntaxerrors ++;
+
+  _reporter.reportSyntax();
+
+  if (parallel || (limit > 0 && syntaxerrors >= limit))
+	  throw Abandon();
+
+  throw SyntaxError();
 }
 
 
 /*
- * Function:	match
+ * Function:	Parser::match
  *
  * Description:	Match the next token against the specified token.  A
- *		failure indicates a syntax error and will terminate the
- *		program since our parser does not do error recovery.
+ *		failure indicates a syntax error.
  */
 
-static void match(int token)
+void Parser::match(int token)
 {
   if (word != token)
 	  error();
@@ -95,7 +201,119 @@ static void match(int token)
 
 
 /*
- * Function:	argument
+ * Function:	Parser::synchronize
+ *
+ * Description:	Recover from a syntax error within a function body by
+ *		skipping tokens through the next semicolon, or up to the
+ *		next closing brace, at the current level of nesting.
+ */
+
+void Parser::synchronize()
+{
+  unsigned depth = 0;
+
+
+  while (word != DONE) {
+	  if (word == '{')
+	    depth ++;
+	  else if (word == '}') {
+	    if (depth == 0)
+		  return;
+
+	    depth --;
+	  }
+	  else if (word == ';' && depth == 0) {
+	    word = nextWord();
+	    return;
+	  }
+
+	  word = nextWord();
+  }
+}
+
+
+/*
+ * Function:	Parser::recover
+ *
+ * Description:	Recover from a syntax error in a global declaration by
+ *		closing any scope we were in and skipping tokens up to the
+ *		next specifier, or through the next semicolon or closing
+ *		brace, outside of any braces or parentheses.
+ */
+
+void Parser::recover()
+{
+  unsigned depth = 0, parens = 0;
+
+
+  while (_current != _context.globals)
+	  finalizeScope();
+
+  while (word != DONE) {
+	  if (word == '{')
+	    depth ++;
+	  else if (word == '(')
+	    parens ++;
+	  else if (word == ')' && parens > 0)
+	    parens --;
+	  else if (word == '}' && depth > 0)
+	    depth --;
+	  else if (depth == 0 && parens == 0) {
+	    if (word == CHAR || word == INT)
+		  return;
+
+	    if (word == ';' || word == '}') {
+		  word = nextWord();
+		  return;
+	    }
+	  }
+
+	  word = nextWord();
+  }
+}
+
+
+/*
+ * Function:	Parser::require
+ *
+ * Description:	Note that the given function is reachable, so if its
+ *		body was skipped then it must be parsed after all.
+ */
+
+void Parser::require(Symbol *function)
+{
+  auto it = definitions.find(function);
+
+  if (it != definitions.end() && !bodies[it->second].required) {
+	  bodies[it->second].required = true;
+	  required.push_back(it->second);
+  }
+}
+
+
+/*
+ * Function:	Parser::callee
+ *
+ * Description:	Lookup the function with the given name for a call.  When
+ *		parsing lazily, a call is what makes a function reachable.
+ */
+
+Symbol *Parser::callee(const Token &name)
+{
+  Symbol *symbol;
+
+
+  symbol = lookupFunction(name);
+
+  if (_context.options.lazy)
+	  require(symbol);
+
+  return symbol;
+}
+
+
+/*
+ * Function:	Parser::argument
  *
  * Description:	Parse an argument to a function call.  The only place
  *		string literals are allowed in Tiny C is here, to enable
@@ -107,28 +325,29 @@ static void match(int token)
  *		  Expression
  */
 
-static Node *argument()
+Node Parser::argument()
 {
-  Node *expr;
+  Node expr;
   Symbol *symbol;
 
 
   if (word == STRLIT) {
-	  expr = new Node(STRLIT, makeLiteral(lexeme));
+	  symbol = _context.literals.insert(tokens->literal(current));
+	  expr = _tree.node(STRLIT, symbol);
 	  match(STRLIT);
 
   }
   else if (word == NAME && (peek() == ',' || peek() == ')')) {
-	  symbol = lookupName(lexeme);
+	  symbol = lookupName(current.atom);
 
 	  if (symbol == nullptr)
-	    symbol = lookupScalar(lexeme);
+	    symbol = lookupScalar(current);
 
-	  expr = new Node(NAME, symbol);
+	  expr = _tree.node(NAME, symbol);
 	  match(NAME);
 
-	  if (expr->type().isScalar() && expr->type().specifier() == CHAR)
-	    expr = new Node(INT, expr);
+	  if (_tree.type(expr).isScalar())
+	    expr = promote(expr);
 
   } 
   else
@@ -139,7 +358,7 @@ static Node *argument()
 
 
 /*
- * Function:	argumentList
+ * Function:	Parser::argumentList
  *
  * Description:	Parse the argument list of a function call.
  *
@@ -148,19 +367,19 @@ static Node *argument()
  *		  Argument , ArgumentList
  */
 
-static void argumentList(Node *expr)
+void Parser::argumentList(Node expr)
 {
-  expr->append(argument());
+  _tree.append(expr, argument());
 
   while (word == ',') {
 	  match(',');
-	  expr->append(argument());
+	  _tree.append(expr, argument());
   }
 }
 
 
 /*
- * Function:	primaryExpression
+ * Function:	Parser::primaryExpression
  *
  * Description:	Parse a primary expression, which will always have a
  *		scalar type.
@@ -175,11 +394,11 @@ static void argumentList(Node *expr)
  *		  name [ Expression ]
  */
 
-static Node *primaryExpression()
+Node Parser::primaryExpression()
 {
-  string name;
+  Token name;
   unsigned size;
-  Node *expr, *left, *right;
+  Node expr, left, right;
   Symbol *symbol;
 
 
@@ -190,51 +409,48 @@ static Node *primaryExpression()
 
   } 
   else if (word == CHARLIT) {
-	  expr = new Node(NUM, makeLiteral(parseString(lexeme)[1]));
+	  expr = _tree.node(NUM, _context.literals.insert(current.value));
 	  match(CHARLIT);
 
   } 
   else if (word == NUM) {
-	  expr = new Node(NUM, makeLiteral(lexeme));
+	  expr = _tree.node(NUM, _context.literals.insert(current.value));
 	  match(NUM);
 
   } 
   else {
-	  name = lexeme;
+	  name = current;
 	  match(NAME);
 
 	  if (word == '(') {
-	    expr = new Node(FUNC, new Node(NAME, lookupFunction(name)));
+	    expr = _tree.node(FUNC, _tree.node(NAME, callee(name)));
 	    match('(');
 
 	    if (word != ')')
 		    argumentList(expr);
 
-	    checkCall(expr);
+	    checkCall(expr, name);
 	    match(')');
 
 	  } 
     else if (word == '[') {
-	    left = new Node(NAME, lookupArray(name));
+	    left = _tree.node(NAME, lookupArray(name));
 	    match('[');
 	    right = expression();
 	    match(']');
 
-	    size = Type(left->symbol()->type().specifier()).size();
+	    size = _context.types.size(_tree.symbol(left)->type().specifier());
 
 	    if (size != 1) {
-		  symbol = makeLiteral(size);
-		  right = new Node('*', right, new Node(NUM, symbol));
+		  symbol = _context.literals.insert(size);
+		  right = _tree.node('*', right, _tree.node(NUM, symbol));
 	    }
 
-	    expr = new Node(INDEX, left, right);
+	    expr = _tree.node(INDEX, left, right);
 
 	  } 
     else {
-	    expr = new Node(NAME, lookupScalar(name));
-
-	    if (expr->type().specifier() == CHAR)
-		    expr = new Node(INT, expr);
+	    expr = promote(_tree.node(NAME, lookupScalar(name)));
 	  }
   }
 
@@ -243,7 +459,7 @@ static Node *primaryExpression()
 
 
 /*
- * Function:	unaryExpression
+ * Function:	Parser::unaryExpression
  *
  * Description:	Parse a unary expression.
  *
@@ -253,21 +469,21 @@ static Node *primaryExpression()
  *		  PrimaryExpression
  */
 
-static Node *unaryExpression()
+Node Parser::unaryExpression()
 {
-  Node *expr;
+  Node expr;
 
 
   if (word == '-') {
 	  match('-');
 	  expr = unaryExpression();
-	  expr = new Node(NEGATE, expr);
+	  expr = _tree.node(NEGATE, expr);
 
   } 
   else if (word == '!') {
 	  match('!');
 	  expr = unaryExpression();
-	  expr = new Node('!', expr);
+	  expr = _tree.node('!', expr);
 
   } 
   else
@@ -278,45 +494,46 @@ static Node *unaryExpression()
 
 
 /*
- * Function:	multiplicativeExpression
+ * Function:	Parser::binaryExpression
  *
- * Description:	Parse a multiplicative expression.
+ * Description:	Parse a binary expression whose operators all have at
+ *		least the given precedence, by precedence climbing.  The
+ *		precedence of each operator comes from the token table, so
+ *		there is no need for a separate function per level.  All
+ *		binary operators are left associative, so the right
+ *		operand may only contain operators of strictly higher
+ *		precedence.
  *
- *		MultiplicativeExpression:
+ *		BinaryExpression:
  *		  UnaryExpression
- *		  MultiplicativeExpression * UnaryExpression
- *		  MultiplicativeExpression / UnaryExpression
- *		  MultiplicativeExpression % UnaryExpression
+ *		  BinaryExpression * UnaryExpression
+ *		  BinaryExpression / UnaryExpression
+ *		  BinaryExpression % UnaryExpression
+ *		  BinaryExpression + BinaryExpression
+ *		  BinaryExpression - BinaryExpression
+ *		  BinaryExpression < BinaryExpression
+ *		  BinaryExpression > BinaryExpression
+ *		  BinaryExpression <= BinaryExpression
+ *		  BinaryExpression >= BinaryExpression
+ *		  BinaryExpression == BinaryExpression
+ *		  BinaryExpression != BinaryExpression
+ *		  BinaryExpression && BinaryExpression
+ *		  BinaryExpression || BinaryExpression
  */
 
-static Node *multiplicativeExpression()
+Node Parser::binaryExpression(int minimum)
 {
-  Node *left, *right;
+  int op, precedence;
+  Node left, right;
 
 
   left = unaryExpression();
 
-  while (1) {
-	  if (word == '*') {
-	    match('*');
-	    right = unaryExpression();
-	    left = new Node('*', left, right);
-
-	  } 
-    else if (word == '/') {
-	    match('/');
-	    right = unaryExpression();
-	    left = new Node('/', left, right);
-
-	  } 
-    else if (word == '%') {
-	    match('%');
-	    right = unaryExpression();
-	    left = new Node('%', left, right);
-
-	  } 
-    else
-	    break;
+  while ((precedence = tokenTable[word].precedence) >= minimum) {
+	  op = word;
+	  match(op);
+	  right = binaryExpression(precedence + 1);
+	  left = _tree.node(op, left, right);
   }
 
   return left;
@@ -324,194 +541,24 @@ static Node *multiplicativeExpression()
 
 
 /*
- * Function:	additiveExpression
- *
- * Description:	Parse an additive expression.
- *
- *		AdditiveExpression:
- *		  MultiplicativeExpression
- *		  AdditiveExpression + MultiplicativeExpression
- *		  AdditiveExpression - MultiplicativeExpression
- */
-
-static Node *additiveExpression()
-{
-  Node *left, *right;
-
-
-  left = multiplicativeExpression();
-
-  while (1) {
-	  if (word == '+') {
-	    match('+');
-	    right = multiplicativeExpression();
-	    left = new Node('+', left, right);
-
-	  } 
-    else if (word == '-') {
-	    match('-');
-	    right = multiplicativeExpression();
-	    left = new Node('-', left, right);
-
-	  } 
-    else
-	    break;
-  }
-
-  return left;
-}
-
-
-/*
- * Function:	relationalExpression
- *
- * Description:	Parse a relational expression.
- *
- *		RelationalExpression:
- *		  AdditiveExpression
- *		  RelationalExpression < AdditiveExpression
- *		  RelationalExpression > AdditiveExpression
- *		  RelationalExpression <= AdditiveExpression
- *		  RelationalExpression >= AdditiveExpression
- */
-
-static Node *relationalExpression()
-{
-  Node *left, *right;
-
-
-  left = additiveExpression();
-
-  while (1) {
-	  if (word == '<') {
-	    match('<');
-	    right = additiveExpression();
-	    left = new Node('<', left, right);
-
-	  } 
-    else if (word == '>') {
-	    match('>');
-	    right = additiveExpression();
-	    left = new Node('>', left, right);
-
-	  } 
-    else if (word == LEQ) {
-	    match(LEQ);
-	    right = additiveExpression();
-	    left = new Node(LEQ, left, right);
-
-	  } 
-    else if (word == GEQ) {
-	    match(GEQ);
-	    right = additiveExpression();
-	    left = new Node(GEQ, left, right);
-
-	  } 
-    else
-	    break;
-  }
-
-  return left;
-}
-
-
-/*
- * Function:	equalityExpression
- *
- * Description:	Parse an equality expression.
- *
- *		EqualityExpression:
- *		  RelationalExpression
- *		  EqualityExpression == RelationalExpression
- *		  EqualityExpression != RelationalExpression
- */
-
-static Node *equalityExpression()
-{
-  Node *left, *right;
-
-
-  left = relationalExpression();
-
-  while (1) {
-	  if (word == EQL) {
-	    match(EQL);
-	    right = relationalExpression();
-	    left = new Node(EQL, left, right);
-
-	  } 
-    else if (word == NEQ) {
-	    match(NEQ);
-	    right = relationalExpression();
-	    left = new Node(NEQ, left, right);
-
-	  } 
-    else
-	    break;
-  }
-
-  return left;
-}
-
-
-/*
- * Function:	andExpression
- *
- * Description:	Parse a logical-and expression.
- *
- *		AndExpression:
- *		  EqualityExpression
- *		  AndExpression && EqualityExpression
- */
-
-static Node *andExpression()
-{
-  Node *left, *right;
-
-
-  left = equalityExpression();
-
-  while (word == AND) {
-	  match(AND);
-	  right = equalityExpression();
-	  left = new Node(AND, left, right);
-  }
-
-  return left;
-}
-
-
-/*
- * Function:	expression
+ * Function:	Parser::expression
  *
  * Description:	Parse an expression, or more specifically a logical-or
  *		expression, since Tiny C does not allow comma or
  *		assignment as an expression operator.
  *
  *		Expression:
- *		  AndExpression
- *		  Expression || AndExpression
+ *		  BinaryExpression
  */
 
-static Node *expression()
+Node Parser::expression()
 {
-  Node *left, *right;
-
-
-  left = andExpression();
-
-  while (word == OR) {
-	  match(OR);
-  	right = andExpression();
-  	left = new Node(OR, left, right);
-  }
-
-  return left;
+  return binaryExpression(LOGICAL_OR);
 }
 
 
 /*
- * Function:	assignment
+ * Function:	Parser::assignment
  *
  * Description:	Parse an assignment statement, or more specifically a
  *		simple expression statement that has a side effect,
@@ -524,56 +571,56 @@ static Node *expression()
  *		  name ( )
  */
 
-static Node *assignment()
+Node Parser::assignment()
 {
-  string name;
+  Token name;
   unsigned size;
-  Node *expr, *left, *right;
+  Node expr, left, right;
   Symbol *symbol;
 
 
-  name = lexeme;
+  name = current;
   match(NAME);
 
   if (word == '=') {
-	  left = new Node(NAME, lookupScalar(name));
+	  left = _tree.node(NAME, lookupScalar(name));
 	  match('=');
 	  right = expression();
-	  expr = new Node('=', left, right);
+	  expr = _tree.node('=', left, right);
   } 
   else if (word == '[') {
-	  left = new Node(NAME, lookupArray(name));
+	  left = _tree.node(NAME, lookupArray(name));
   	match('[');
 	  right = expression();
 	  match(']');
 
-	  size = Type(left->symbol()->type().specifier()).size();
+	  size = _context.types.size(_tree.symbol(left)->type().specifier());
 
   	if (size != 1) {
-	      symbol = makeLiteral(size);
-	     right = new Node('*', right, new Node(NUM, symbol));
+	      symbol = _context.literals.insert(size);
+	     right = _tree.node('*', right, _tree.node(NUM, symbol));
 	  }
 
-  	left = new Node(INDEX, left, right);
+  	left = _tree.node(INDEX, left, right);
 
   	match('=');
   	right = expression();
-  	expr = new Node('=', left, right);
+  	expr = _tree.node('=', left, right);
 
   } 
   else if (word == '(') {
-	  expr = new Node(PROC, new Node(NAME, lookupFunction(name)));
+	  expr = _tree.node(PROC, _tree.node(NAME, callee(name)));
 	  match('(');
 
 	  if (word != ')')
 	    argumentList(expr);
 
-	  checkCall(expr);
+	  checkCall(expr, name);
 	  match(')');
 
   } 
   else {
-	  expr = nullptr;
+	  expr = Tree::none;
 	  error();
   }
 
@@ -582,7 +629,7 @@ static Node *assignment()
 
 
 /*
- * Function:	statements
+ * Function:	Parser::statements
  *
  * Description:	Parse a possibly empty sequence of statements.  Rather than
  *		checking if the next token starts a statement, we check if
@@ -594,22 +641,22 @@ static Node *assignment()
  *		  Statement Statements
  */
 
-static Node *statements()
+Node Parser::statements()
 {
-  Node *stmt;
+  Node stmt;
 
 
-  stmt = new Node(BLOCK);
+  stmt = _tree.node(BLOCK);
 
-  while (word != '}')
-	  stmt->append(statement());
+  while (word != '}' && word != DONE)
+	  _tree.append(stmt, statement());
 
   return stmt;
 }
 
 
 /*
- * Function:	statement
+ * Function:	Parser::statement
  *
  * Description:	Parse a statement.  Note that Tiny C has so few
  *		statements that we handle them all in this one function.
@@ -623,94 +670,149 @@ static Node *statements()
  *		  do Statement while ( Expression ) ;
  *		  return Expression ;
  *		  Assignment ;
+ *
+ *		Statements may be nested arbitrarily deeply, so rather
+ *		than recursing for each nested statement, we keep our own
+ *		stack of the statements that are still open.  Once a
+ *		statement is complete, it is handed to the innermost open
+ *		statement, which either asks for another statement or is
+ *		itself complete.  The work done, and the order in which it
+ *		is done, is exactly that of the obvious recursive parser.
+ *
+ *		After a syntax error, we skip to the end of the statement
+ *		and abandon any statements that were still open within
+ *		the innermost block, which then carries on as usual.
  */
 
-static Node *statement()
+Node Parser::statement()
 {
-  Node *stmt;
+  vector<Node> open;
+  Node stmt, outer;
+  bool resume = false;
 
 
-  if (word == '{') {
-	  match('{');
-	  stmt = statements();
-	  match('}');
+  while (1) {
+    try {
+	  stmt = Tree::none;
+
+	  if (resume)
+	    resume = false;
+	  else if (word == '{') {
+	    match('{');
+	    open.push_back(_tree.node(BLOCK));
 
-  }
-  else if (word == IF) {
-  	stmt = new Node(IF);
-  
-  	match(IF);
-  	match('(');
-  	stmt->append(expression());
-  	match(')');
-  	stmt->append(statement());
-
-	  if (word == ELSE) {
-	      match(ELSE);
-	      stmt->append(statement());
 	  }
+	  else if (word == IF) {
+	    open.push_back(_tree.node(IF));
 
-  } 
-  else if (word == FOR) {
-	  stmt = new Node(FOR);
-
-	  match(FOR);
-    match('(');
-    stmt->append(assignment());
-    match(';');
-    stmt->append(expression());
-    match(';');
-    stmt->append(assignment());
-    match(')');
-    stmt->append(statement());
+	    match(IF);
+	    match('(');
+	    _tree.append(open.back(), expression());
+	    match(')');
+	    continue;
 
-  } 
-  else if (word == WHILE) {
-    stmt = new Node(WHILE);
+	  }
+	  else if (word == FOR) {
+	    open.push_back(_tree.node(FOR));
 
-    match(WHILE);
-    match('(');
-    stmt->append(expression());
-    match(')');
-    stmt->append(statement());
+	    match(FOR);
+	    match('(');
+	    _tree.append(open.back(), assignment());
+	    match(';');
+	    _tree.append(open.back(), expression());
+	    match(';');
+	    _tree.append(open.back(), assignment());
+	    match(')');
+	    continue;
 
-  } 
-  else if (word == DO) {
-    stmt = new Node(DO);
+	  }
+	  else if (word == WHILE) {
+	    open.push_back(_tree.node(WHILE));
 
-    match(DO);
-    stmt->append(statement());
-    match(WHILE);
-    match('(');
-    stmt->append(expression());
-    match(')');
-    match(';');
+	    match(WHILE);
+	    match('(');
+	    _tree.append(open.back(), expression());
+	    match(')');
+	    continue;
 
-  } 
-  else if (word == RETURN) {
-    stmt = new Node(RETURN);
+	  }
+	  else if (word == DO) {
+	    open.push_back(_tree.node(DO));
 
-    match(RETURN);
-    stmt->append(expression());
-    match(';');
+	    match(DO);
+	    continue;
 
-  } 
-  else {
-    stmt = assignment();
-    match(';');
-  }
+	  }
+	  else if (word == RETURN) {
+	    stmt = _tree.node(RETURN);
 
-  return stmt;
+	    match(RETURN);
+	    _tree.append(stmt, expression());
+	    match(';');
+
+	  }
+	  else {
+	    stmt = assignment();
+	    match(';');
+	  }
+
+	  while (!open.empty()) {
+	    outer = open.back();
+
+	    if (stmt != Tree::none)
+		  _tree.append(outer, stmt);
+
+	    if (_tree.token(outer) == BLOCK) {
+		  if (word != '}')
+		    break;
+
+		  match('}');
+
+	    }
+	    else if (_tree.token(outer) == IF) {
+		  if (_tree.children(outer) == 2 && word == ELSE) {
+		    match(ELSE);
+		    break;
+		  }
+
+	    }
+	    else if (_tree.token(outer) == DO) {
+		  match(WHILE);
+		  match('(');
+		  _tree.append(outer, expression());
+		  match(')');
+		  match(';');
+	    }
+
+	    stmt = outer;
+	    open.pop_back();
+	  }
+
+	  if (open.empty())
+	    return stmt;
+
+    } catch (const SyntaxError &) {
+	  synchronize();
+
+	  while (!open.empty() && _tree.token(open.back()) != BLOCK)
+	    open.pop_back();
+
+	  if (open.empty() || word == DONE)
+	    return _tree.node(BLOCK);
+
+	  resume = true;
+    }
+  }
 }
 
 
 /*
- * Function:	specifier
+ * Function:	Parser::specifier
  *
  * Description:	Parse a type specifier, which in Tiny C is char or int.
  */
 
-static int specifier()
+int Parser::specifier()
 {
     if (word == INT) {
 	match(INT);
@@ -723,7 +825,7 @@ static int specifier()
 
 
 /*
- * Function:	parameter
+ * Function:	Parser::parameter
  *
  * Description:	Parse a parameter, which in Tiny C is either a scalar
  *		or an array in which the size is not specified.
@@ -733,18 +835,18 @@ static int specifier()
  *		  Specifier name [ ]
  */
 
-static void parameter(Types *formals)
+void Parser::parameter(Types *formals)
 {
   int typespec;
-  string name;
+  Token name;
 
   typespec = specifier();
-  name = lexeme;
+  name = current;
   match(NAME);
 
   if (word == '[') {
-	  insertName(name, Type(typespec, 0U));
-	  formals->push_back(Type(typespec, 0U));
+	  insertName(name, _context.types.array(typespec, 0));
+	  formals->push_back(_context.types.array(typespec, 0));
 	  match('[');
 	  match(']');
 
@@ -757,7 +859,7 @@ static void parameter(Types *formals)
 
 
 /*
- * Function:	parameterList
+ * Function:	Parser::parameterList
  *
  * Description:	Parse a non-empty parameter list.
  *
@@ -766,7 +868,7 @@ static void parameter(Types *formals)
  *		   Parameter , ParameterList
  */
 
-static void parameterList(Types *formals)
+void Parser::parameterList(Types *formals)
 {
   parameter(formals);
 
@@ -778,7 +880,7 @@ static void parameterList(Types *formals)
 
 
 /*
- * Function:	parameters
+ * Function:	Parser::parameters
  *
  * Description:	Parse the parameters of a function, but not the
  *		opening or closing parentheses.
@@ -788,7 +890,7 @@ static void parameterList(Types *formals)
  *		  ParameterList
  */
 
-static void parameters(Types *formals)
+void Parser::parameters(Types *formals)
 {
   if (word == VOID)
 	  match(VOID);
@@ -798,7 +900,7 @@ static void parameters(Types *formals)
 
 
 /*
- * Function:	declarator
+ * Function:	Parser::declarator
  *
  * Description:	Parse a declarator, which in Tiny C is either a scalar
  *		or a single-dimensional array.
@@ -808,19 +910,19 @@ static void parameters(Types *formals)
  *		  name [ num ]
  */
 
-static void declarator(int typespec)
+void Parser::declarator(int typespec)
 {
-  string name;
+  Token name;
   unsigned length;
 
 
-  name = lexeme;
+  name = current;
   match(NAME);
 
   if (word == '[') {
 	  match('[');
-	  length = (word == NUM ? stoul(lexeme) : 1);
-	  checkArray(insertName(name, Type(typespec, length)));
+	  length = (word == NUM ? current.value : 1);
+	  checkArray(insertName(name, _context.types.array(typespec, length)));
 	  match(NUM);
 	  match(']');
 
@@ -831,7 +933,7 @@ static void declarator(int typespec)
 
 
 /*
- * Function:	moreDeclarators
+ * Function:	Parser::moreDeclarators
  *
  * Description:	Parse any remaining declarators in a declaration after
  *		the first declarator.
@@ -841,7 +943,7 @@ static void declarator(int typespec)
  *		  , Declararor MoreDeclarators
  */
 
-static void moreDeclarators(int typespec)
+void Parser::moreDeclarators(int typespec)
 {
   while (word == ',') {
 	  match(',');
@@ -851,7 +953,7 @@ static void moreDeclarators(int typespec)
 
 
 /*
- * Function:	declaration
+ * Function:	Parser::declaration
  *
  * Description:	Parse a single declaration.
  *
@@ -859,7 +961,7 @@ static void moreDeclarators(int typespec)
  *		  Specifier Declarator MoreDeclarators ;
  */
 
-static void declaration()
+void Parser::declaration()
 {
   int typespec;
 
@@ -872,7 +974,7 @@ static void declaration()
 
 
 /*
- * Function:	declarations
+ * Function:	Parser::declarations
  *
  * Description:	Parse a possible empty sequence of declarations.
  *
@@ -881,7 +983,7 @@ static void declaration()
  *		  Declaration Declarations
  */
 
-static void declarations()
+void Parser::declarations()
 {
   while (word == CHAR || word == INT)
 	  declaration();
@@ -889,10 +991,272 @@ static void declarations()
 
 
 /*
- * Function:	globalDeclaration
+ * Function:	Parser::functionBody
+ *
+ * Description:	Parse the body of a function, except for the closing
+ *		brace, and return its statements.  After a syntax error in
+ *		the declarations, we skip to the end of the declaration.
+ *
+ *		Body:
+ *		  { Declarations Statements }
+ */
+
+Node Parser::functionBody()
+{
+  match('{');
+
+  while (1) {
+    try {
+	  declarations();
+	  break;
+    } catch (const SyntaxError &) {
+	  synchronize();
+    }
+  }
+
+  return statements();
+}
+
+
+/*
+ * Function:	Parser::skipBody
+ *
+ * Description:	Skip the body of the given function by matching braces,
+ *		and remember where it is so that we can come back and
+ *		parse it later.  The arena of the function goes with it,
+ *		since its scope is there.  When parsing lazily, a body is
+ *		parsed only if it turns out to be reachable, and a body
+ *		that is never parsed is never checked either.
+ *
+ *		We declare every function that the body looks like it
+ *		calls, and limit the body to seeing only the global
+ *		declarations up to this point, so that it will be checked
+ *		just as if it were parsed right away.  A name that already
+ *		appeared in the body is not declared, since its first
+ *		appearance, whether as a declaration or as an undeclared
+ *		use, will have given it a local symbol.  When parsing in
+ *		parallel, lexical errors are also reported when the body
+ *		is parsed rather than here, and any diagnostics for the
+ *		text before the body are kept with it.
+ */
+
+void Parser::skipBody(Symbol *function, Scope *scope)
+{
+  unordered_set<Atom> seen;
+  unsigned depth;
+
+
+  if (word != '{')
+	  error();
+
+  if (parallel)
+	  _reporter.flush();
+
+  definitions.emplace(function, bodies.size());
+  bodies.push_back({function, scope, current.offset, false, false});
+  bodies.back().arena = move(_locals);
+
+  if (parallel) {
+	  bodies.back().before = pending.str();
+	  pending.str("");
+  }
+
+  tokens->quiet(parallel);
+  depth = 0;
+
+  while (word != DONE) {
+	  if (word == '{')
+	    depth ++;
+	  else if (word == '}' && -- depth == 0)
+	    break;
+	  else if (word == NAME && seen.insert(current.atom).second
+		  && peek() == '(')
+	    declareFunction(current.atom);
+
+	  word = nextWord();
+  }
+
+  scope->limit();
+  tokens->quiet(false);
+
+  if (word != DONE)
+	  word = nextWord();
+}
+
+
+/*
+ * Function:	Parser::parseBody
+ *
+ * Description:	Parse a function body that was skipped earlier, by
+ *		replaying its tokens within the scope of the function.
+ *		Lexical errors in the body were already reported when it
+ *		was skipped, unless we are parsing in parallel.  We never
+ *		look past the closing brace, since the tokens after it
+ *		belong to someone else, so there is nothing to recover
+ *		from if it is missing.  Unless there were syntax errors,
+ *		the tree is written to the body, since it is freed along
+ *		with the rest of the function once we are done.  When
+ *		parsing lazily, bodies are parsed out of order, so their
+ *		diagnostics are kept until the very end and sorted then.
+ */
+
+void Parser::parseBody(Body &body)
+{
+  TokenStream stream(_reporter, body.offset);
+  TokenStream *saved = tokens;
+  ostringstream output;
+  Node tree;
+
+
+  tokens = &stream;
+  tokens->quiet(!parallel);
+  word = nextWord();
+
+  _locals = move(body.arena);
+  reopenScope(body.scope);
+  tree = functionBody();
+
+  try {
+	  if (word != '}')
+	    error();
+  } catch (const SyntaxError &) {
+  }
+
+  if (syntaxerrors == 0 && _context.options.image)
+	  body.output = image.function(_context.atoms, _context.types,
+		  _tree, tree, body.function, body.scope);
+  else if (syntaxerrors == 0) {
+	  _tree.write(output, tree, _context.atoms) << endl;
+	  body.output = output.str();
+  }
+
+  if (parallel)
+	  _reporter.flush();
+
+  finalizeScope();
+  tokens = saved;
+}
+
+
+/*
+ * Function:	Parser::parseReachable
+ *
+ * Description:	Parse every skipped function body that is reachable
+ *		from main or an exported function, and write them out in
+ *		the order they were defined.  Parsing a body may make more
+ *		functions reachable, so we work through a queue.  Though
+ *		the whole translation unit has been seen by now, a body
+ *		parsed this way still sees only the global declarations
+ *		that precede it, as skipBody arranged.
+ */
+
+void Parser::parseReachable()
+{
+  require(lookupName(_context.atoms.intern("main")));
+
+  for (const auto &name : _context.options.exports)
+	  require(lookupName(_context.atoms.intern(name)));
+
+  for (size_t i = 0; i < required.size(); i ++)
+	  parseBody(bodies[required[i]]);
+
+  if (syntaxerrors == 0)
+	  for (const auto &body : bodies)
+	    emit(body.output);
+}
+
+
+/*
+ * Function:	Parser::parseTask
+ *
+ * Description:	Parse one function body on a worker thread, using a new
+ *		parser of its own.  The tree and any diagnostics are
+ *		written to buffers kept with the body, so that they can be
+ *		written out in order afterwards, and so are the messages
+ *		the body reported only once.
+ */
+
+void Parser::parseTask(Body &body)
+{
+  ostringstream errors;
+  Parser parser(_context, errors);
+
+
+  try {
+	  parser.parseBody(body);
+  } catch (const Abandon &) {
+	  body.failed = true;
+  }
+
+  body.errors = errors.str();
+  body.seen = parser._reporter.seen();
+}
+
+
+/*
+ * Function:	Parser::parseParallel
+ *
+ * Description:	Parse every skipped function body on a pool of threads,
+ *		and then write out the results in the order the bodies
+ *		were defined, exactly as if they had been parsed one at a
+ *		time.  If any body has a syntax error, nothing is written
+ *		and the compilation is abandoned.  So too if there were
+ *		more diagnostics than may be written, since which of them
+ *		are dropped depends on the order in which they are seen,
+ *		or if two bodies, or a body and a global declaration,
+ *		reported the same message that may be reported only once,
+ *		since each kept its own.  Any other exception thrown while
+ *		parsing a body is rethrown here by the pool when we wait
+ *		for it.
+ */
+
+void Parser::parseParallel()
+{
+  ThreadPool pool(_context.options.threads);
+  unsigned limit = _context.options.diagnosticlimit;
+
+
+  for (auto &body : bodies)
+	  pool.submit([this, &body]() { parseTask(body); });
+
+  pool.wait();
+
+  for (const auto &body : bodies)
+	  if (body.failed)
+	    throw Abandon();
+
+  if (limit > 0 && (unsigned) _context.numerrors > limit)
+	  throw Abandon();
+
+  if (_context.options.dedup) {
+	  vector<Reporter::Key> keys = _reporter.seen();
+	  set<Reporter::Key> seen(keys.begin(), keys.end());
+
+	  for (const auto &body : bodies)
+	    for (const auto &key : body.seen)
+		  if (!seen.insert(key).second)
+		    throw Abandon();
+  }
+
+  for (const auto &body : bodies) {
+	  _context.errors << body.before << body.errors;
+	  emit(body.output);
+  }
+}
+
+
+/*
+ * Function:	Parser::globalDeclaration
  *
  * Description:	Parse a global (i.e., top-level) declaration, which is
  *		either a variable declaration or a function definition.
+ *		A function body that is parsed right away is written out
+ *		at once, and then everything local to it is freed and the
+ *		source before its closing brace is released, so that
+ *		memory is bounded by the largest function rather than by
+ *		the size of the file.  Diagnostics are flushed before and
+ *		after the body, just as they are when it is skipped and
+ *		parsed in parallel, so they come out the same either way.
  *
  *		GlobalDeclaration:
  *		  Specifier name MoreDeclarators ;
@@ -900,22 +1264,26 @@ static void declarations()
  *		  Specifier name ( Parameters ) { Declarations Statements }
  */
 
-static void globalDeclaration()
+void Parser::globalDeclaration()
 {
   unsigned length;
   int typespec;
-  string name;
-  Types *formals;
+  Token name;
+  Types formals(_locals);
+  Symbol *symbol;
+  Scope *scope;
+  bool fresh;
+  Node tree;
     
     
   typespec = specifier();
-  name = lexeme;
+  name = current;
   match(NAME);
 
   if (word == '[') {
 	  match('[');
-	  length = (word == NUM ? stoul(lexeme) : 1);
-	  checkArray(insertName(name, Type(typespec, length)));
+	  length = (word == NUM ? current.value : 1);
+	  checkArray(insertName(name, _context.types.array(typespec, length)));
 	  match(NUM);
 	  match(']');
 	  moreDeclarators(typespec);
@@ -923,16 +1291,41 @@ static void globalDeclaration()
 
   } 
   else if (word == '(') {
-	  formals = new Types;
-	  insertName(name, Type(typespec, formals));
-	  initializeScope();
-	  match('(');
-	  parameters(formals);
-	  match(')');
-	  match('{');
-	  declarations();
-	  cout << statements() << endl;
-	  match('}');
+	  fresh = _current->find(name.atom) == nullptr;
+	  symbol = insertName(name, _context.types.function(typespec, nullptr));
+	  scope = initializeScope();
+
+	  try {
+	    match('(');
+	    parameters(&formals);
+	    match(')');
+	  } catch (const SyntaxError &) {
+	    if (fresh)
+		  symbol->type(_context.types.function(typespec, &formals));
+
+	    throw;
+	  }
+
+	  if (fresh)
+	    symbol->type(_context.types.function(typespec, &formals));
+
+	  if (_context.options.lazy || parallel)
+	    skipBody(symbol, scope);
+	  else {
+	    _reporter.flush();
+	    tree = functionBody();
+	    _reporter.flush();
+
+	    if (syntaxerrors == 0 && _context.options.image)
+		  image.write(_context.output, image.function(_context.atoms,
+			  _context.types, _tree, tree, symbol, scope));
+	    else if (syntaxerrors == 0)
+		  _tree.write(_context.output, tree, _context.atoms) << endl;
+
+	    _context.source.release(current.offset);
+	    match('}');
+	  }
+
 	  finalizeScope();
 
   } 
@@ -945,36 +1338,138 @@ static void globalDeclaration()
 
 
 /*
- * Function:	translationUnit
+ * Function:	Parser::emit
+ *
+ * Description:	Write out the output of a function body that was parsed
+ *		earlier, which is either its tree as text or its section
+ *		of the image.  A body that was never parsed has no output.
+ */
+
+void Parser::emit(const string &output)
+{
+  if (output.empty())
+	  return;
+
+  if (_context.options.image)
+	  image.write(_context.output, output);
+  else
+	  _context.output << output << flush;
+}
+
+
+/*
+ * Function:	Parser::finish
+ *
+ * Description:	Write out any diagnostics that are left, and finish
+ *		writing the image, if there is one, with the global
+ *		symbols.  We finish even when the compilation is
+ *		abandoned, so that whatever functions were written can
+ *		still be read.
+ */
+
+void Parser::finish()
+{
+  _reporter.finish();
+
+  if (_context.options.image)
+	  image.finish(_context.output, image.globals(_context.atoms,
+		  _context.types, _context.globals));
+}
+
+
+/*
+ * Function:	Parser::translationUnit
  *
  * Description:	Parse the current translation unit (i.e., file), which
  *		consists of a possibly empty sequence of global
- *		declarations.
+ *		declarations.  After a syntax error in a global
+ *		declaration, we carry on with the next one.  Return
+ *		whether it was parsed without any syntax errors.
  *
  *		TranslationUnit:
  *		  empty
  *		  GlobalDeclaration TranslationUnit
  */
 
-static void translationUnit()
+bool Parser::translationUnit()
 {
+  TokenStream stream(_reporter, _context.options.pipelined);
+
+
+  tokens = &stream;
   initializeScope();
 
-  while (word != DONE)
-	  globalDeclaration();
+  if (parallel) {
+	  _reporter.stream(pending);
+	  word = nextWord();
+
+	  while (word != DONE)
+	    globalDeclaration();
 
+	  _reporter.stream(_context.errors);
+	  parseParallel();
+	  _context.errors << pending.str();
+
+	  finish();
+	  finalizeScope();
+	  return true;
+  }
+
+  try {
+	  word = nextWord();
+
+	  while (word != DONE) {
+	    try {
+		  globalDeclaration();
+	    } catch (const SyntaxError &) {
+		  recover();
+	    }
+	  }
+
+	  if (_context.options.lazy)
+	    parseReachable();
+  } catch (const Abandon &) {
+	  finish();
+	  return false;
+  }
+
+  finish();
   finalizeScope();
+  return syntaxerrors == 0;
 }
 
 
 /*
- * Function:	main
+ * Function:	compile
  *
- * Description:	Analyze the standard input stream.
+ * Description:	Compile the source of the given context, writing the
+ *		abstract syntax trees and any diagnostics to its streams.
+ *		If parsing in parallel is abandoned at a syntax error,
+ *		nothing has been written yet, so we start over on one
+ *		thread with a fresh context, which recovers from the error
+ *		just as it would have without -j.  Return whether it was
+ *		compiled without any syntax errors.
  */
 
-int main()
+bool compile(CompilationContext &context)
 {
-  word = nextWord();
-  translationUnit();
+  Options options = context.options;
+  bool succeeded;
+
+
+  try {
+	  Parser parser(context, context.errors);
+	  return parser.translationUnit();
+  } catch (const Abandon &) {
+  }
+
+  options.threads = 0;
+  CompilationContext serial(context.source, options, context.output,
+	  context.errors);
+
+  Parser parser(serial, serial.errors);
+  succeeded = parser.translationUnit();
+  context.numerrors = serial.numerrors.load();
+  return succeeded;
 }
+
@@ -0,0 +1,14 @@
+/*
+ * File:	parser.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		the parser for Tiny C.
+ */
+
+# ifndef PARSER_H
+# define PARSER_H
+# include "CompilationContext.h"
+
+bool compile(CompilationContext &context);
+
+# endif /* PARSER_H */
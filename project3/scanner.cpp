@@ -0,0 +1,434 @@
+/*
+ * File:	scanner.cpp
+ *
+ * Description:	This file contains the member function definitions for the
+ *		hand-written lexical analyzer for Tiny C.  It accepts
+ *		exactly the same language as the flex description in
+ *		bench/flex/lexer.l, which we keep around only as a
+ *		reference for benchmarking.
+ *
+ *		Rather than running one DFA transition per byte, we work
+ *		on the entire source in memory, classify the first
+ *		character of each token with a table, and skip white space
+ *		and comments a block at a time.  The source is never
+ *		modified, so each lexeme is simply a view into it.
+ */
+
+# include <climits>
+# include <cstring>
+# include <iostream>
+# include "lexer.h"
+# include "tokens.h"
+# include "string.h"
+# include "simd.h"
+
+using namespace std;
+
+
+/*
+ * The character classes used to dispatch on the first character of a
+ * token.  An operator is a character that may start a two-character
+ * token.  Anything unclassified is an error.
+ */
+
+enum { X, S, D, L, Q, P, O, C };
+
+static const unsigned char classes[256] = {
+    X, X, X, X, X, X, X, X, X, S, S, S, S, S, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    S, O, Q, X, X, P, O, Q, P, P, P, O, P, O, X, C,
+    D, D, D, D, D, D, D, D, D, D, X, P, O, O, O, X,
+    X, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L,
+    L, L, L, L, L, L, L, L, L, L, L, P, X, P, X, L,
+    X, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L,
+    L, L, L, L, L, L, L, L, L, L, L, P, O, P, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+};
+
+
+/*
+ * The keywords of Tiny C are recognized with a perfect hash on the first
+ * and last characters and the length, which maps each keyword to its own
+ * slot.  The slots are filled in at compile time from the token table,
+ * and any collision is a compile-time error.  Each slot holds the token
+ * of its keyword, or zero.
+ */
+
+static constexpr unsigned hashKeyword(const char *s, unsigned n)
+{
+    return ((unsigned char) s[0] * 2 + ((unsigned char) s[n - 1] + n) * 19)
+	& 63;
+}
+
+struct KeywordTable {
+    short slots[64];
+    bool perfect;
+};
+
+static constexpr KeywordTable makeKeywordTable()
+{
+    KeywordTable table = {};
+
+
+    table.perfect = true;
+
+    for (int token = 0; token < NTOKENS; token ++)
+	if (tokenTable[token].keyword) {
+	    unsigned h = hashKeyword(tokenTable[token].lexeme, tokenTable[token].length);
+
+	    if (table.slots[h] != 0)
+		table.perfect = false;
+
+	    table.slots[h] = token;
+	}
+
+    return table;
+}
+
+static constexpr KeywordTable keywords = makeKeywordTable();
+static_assert(keywords.perfect, "keyword hash is not perfect");
+
+
+/*
+ * Function:	isIdentifier (private)
+ *
+ * Description:	Return whether the given character may appear in an
+ *		identifier after the first character.
+ */
+
+static inline bool isIdentifier(char c)
+{
+    return classes[(unsigned char) c] == L || classes[(unsigned char) c] == D;
+}
+
+
+/*
+ * Function:	keyword (private)
+ *
+ * Description:	Return the token for the given identifier if it is a
+ *		keyword, and NAME otherwise.  All keywords are between two
+ *		and eight lowercase letters long.
+ */
+
+static int keyword(const char *s, unsigned n)
+{
+    int token;
+
+
+    if (n < 2 || n > 8 || *s < 'a')
+	return NAME;
+
+    token = keywords.slots[hashKeyword(s, n)];
+
+    if (token != 0 && tokenTable[token].length == n
+	    && memcmp(s, tokenTable[token].lexeme, n) == 0)
+	return token;
+
+    return NAME;
+}
+
+
+/*
+ * Function:	scanLiteral (private)
+ *
+ * Description:	Scan a string or character literal starting at the given
+ *		opening quote.  Return a pointer just past the closing
+ *		quote, or a null pointer if the literal is malformed, in
+ *		which case the quote by itself is an erroneous token.  An
+ *		escape may not be followed by a newline, and a character
+ *		literal may not be empty.  We also note whether there were
+ *		any escape sequences, since otherwise there is nothing to
+ *		decode.
+ */
+
+static const char *scanLiteral(const char *p, const char *limit,
+	bool &escaped)
+{
+    char quote = *p ++;
+    const char *start = p;
+
+
+    escaped = false;
+
+
+    while (p < limit) {
+	if (*p == quote)
+	    return (quote == '\'' && p == start) ? nullptr : p + 1;
+
+	if (*p == '\n')
+	    return nullptr;
+
+	if (*p == '\\') {
+	    if (limit - p < 2 || p[1] == '\n')
+		return nullptr;
+
+	    escaped = true;
+	    p ++;
+	}
+
+	p ++;
+    }
+
+    return nullptr;
+}
+
+
+/*
+ * Function:	operatorToken (private)
+ *
+ * Description:	Return the token for an operator that may consist of two
+ *		characters, and advance the given pointer past it.  A
+ *		lone | or & is not a token.
+ */
+
+static int operatorToken(const char *&p, const char *limit)
+{
+    char c = p[0], d = p + 1 < limit ? p[1] : '\0';
+
+
+    p ++;
+
+    switch (c) {
+    case '|':
+	return d == '|' ? (p ++, OR) : ERROR;
+
+    case '&':
+	return d == '&' ? (p ++, AND) : ERROR;
+
+    case '=':
+	return d == '=' ? (p ++, EQL) : '=';
+
+    case '!':
+	return d == '=' ? (p ++, NEQ) : '!';
+
+    case '<':
+	return d == '=' ? (p ++, LEQ) : '<';
+
+    case '>':
+	return d == '=' ? (p ++, GEQ) : '>';
+
+    case '+':
+	return d == '+' ? (p ++, INC) : '+';
+
+    default:
+	return d == '-' ? (p ++, DEC) : '-';
+    }
+}
+
+
+/*
+ * Function:	Lexer::Lexer (constructor)
+ *
+ * Description:	Initialize this lexer to analyze the given source, which
+ *		must outlive it, starting at the given offset.  Names are
+ *		interned in the given table of atoms.
+ */
+
+Lexer::Lexer(const Source &source, Atoms &atoms, size_t offset)
+    : _source(source), _atoms(atoms), _cursor(source.begin() + offset)
+{
+}
+
+
+/*
+ * Function:	Lexer::scan
+ *
+ * Description:	Scan the next token from the source into the given
+ *		record.  A token of kind DONE is returned at the end of
+ *		the source, and forever after.
+ */
+
+void Lexer::scan(Token &token)
+{
+    const char *p, *q, *start, *limit;
+    bool escaped;
+
+
+    limit = _source.end();
+    p = _cursor;
+    escaped = false;
+
+    while (1) {
+	if (p < limit && classes[(unsigned char) *p] == S)
+	    p = skipSpace(p, limit);
+
+	if (limit - p >= 2 && p[0] == '/' && p[1] == '*')
+	    if ((q = skipComment(p + 2, limit)) != nullptr) {
+		p = q;
+		continue;
+	    }
+
+	break;
+    }
+
+    start = p;
+    token.error = LEX_OK;
+
+    if (p == limit)
+	token.kind = DONE;
+
+    else switch (classes[(unsigned char) *p]) {
+    case L:
+	while (++ p < limit && isIdentifier(*p))
+	    continue;
+
+	token.kind = keyword(start, p - start);
+
+	if (token.kind == NAME)
+	    token.atom = _atoms.intern(string_view(start, p - start));
+
+	break;
+
+    case D:
+	while (++ p < limit && classes[(unsigned char) *p] == D)
+	    continue;
+
+	token.kind = NUM;
+	break;
+
+    case Q:
+	if ((q = scanLiteral(p, limit, escaped)) != nullptr) {
+	    token.kind = (*p == '"' ? STRLIT : CHARLIT);
+	    p = q;
+	} else
+	    token.kind = (p ++, ERROR);
+
+	break;
+
+    case O:
+	token.kind = operatorToken(p, limit);
+	break;
+
+    case P: case C:
+	token.kind = *p ++;
+	break;
+
+    default:
+	token.kind = (p ++, ERROR);
+	break;
+    }
+
+    _cursor = p;
+    token.offset = start - _source.begin();
+    token.length = p - start;
+
+    if (token.kind == NUM)
+	decodeNumber(token);
+    else if (token.kind == STRLIT || token.kind == CHARLIT)
+	decodeString(token, escaped);
+}
+
+
+/*
+ * Function:	Lexer::decodeNumber (private)
+ *
+ * Description:	Compute the value of an integer constant and check that
+ *		it is valid.  As with strtol, a leading zero indicates an
+ *		octal constant and only the longest valid prefix is
+ *		considered.
+ */
+
+void Lexer::decodeNumber(Token &token) const
+{
+    unsigned base, digit;
+    string_view text;
+    long val;
+
+
+    text = _source.text(token.offset, token.length);
+    base = (text[0] == '0' ? 8 : 10);
+    val = 0;
+
+    for (char c : text) {
+	if ((digit = c - '0') >= base)
+	    break;
+
+	if ((val = val * base + digit) > INT_MAX) {
+	    token.error = LEX_TOO_LARGE;
+	    val = INT_MAX;
+	    break;
+	}
+    }
+
+    token.value = val;
+}
+
+
+/*
+ * Function:	Lexer::decodeString (private)
+ *
+ * Description:	Decode a string or character literal and check that it
+ *		is valid.  Only a literal with escape sequences actually
+ *		needs decoding, which we do directly into our own memory.
+ *		A character literal only needs its first character.
+ */
+
+void Lexer::decodeString(Token &token, bool escaped)
+{
+    bool invalid, overflow;
+    string_view text;
+    unsigned length;
+    char *p;
+
+
+    text = _source.text(token.offset + 1, token.length - 2);
+
+    if (!escaped) {
+	if (token.kind == CHARLIT) {
+	    token.value = (signed char) text[0];
+
+	    if (text.size() > 1)
+		token.error = LEX_MULTI_CHARACTER;
+
+	} else
+	    token.decoded = nullptr;
+
+	return;
+    }
+
+    p = static_cast<char *>(_literals.allocate(sizeof(length) + text.size(),
+	1));
+    length = parseString(text, p + sizeof(length), invalid, overflow);
+
+    if (invalid)
+	token.error = LEX_UNKNOWN_ESCAPE;
+    else if (overflow)
+	token.error = LEX_OUT_OF_RANGE;
+    else if (token.kind == CHARLIT && length > 1)
+	token.error = LEX_MULTI_CHARACTER;
+
+    if (token.kind == CHARLIT) {
+	token.value = (signed char) p[sizeof(length)];
+
+    } else {
+	memcpy(p, &length, sizeof(length));
+	token.decoded = p;
+    }
+}
+
+
+/*
+ * Function:	Lexer::literal
+ *
+ * Description:	Return the decoded value of the given string literal.
+ */
+
+string_view Lexer::literal(const Token &token) const
+{
+    unsigned length;
+
+
+    if (token.decoded == nullptr)
+	return _source.text(token.offset + 1, token.length - 2);
+
+    memcpy(&length, token.decoded, sizeof(length));
+    return string_view(token.decoded + sizeof(length), length);
+}
+
@@ -0,0 +1,460 @@
+/*
+ * File:	server.cpp
+ *
+ * Description:	This file contains the public and private function
+ *		definitions for the compile server for Tiny C.
+ *
+ *		A client sends a request consisting of its command-line
+ *		arguments and the text of one source file.  The server
+ *		compiles the source and replies with the exit status, the
+ *		output, and the diagnostics.  A client may send any number
+ *		of requests over one connection.  Every message is a
+ *		sequence of fields, and each field is its length as a
+ *		32-bit integer followed by its bytes.  Since both ends are
+ *		on the same machine, integers are in its own byte order.
+ *		The server does not trust the lengths it is sent: a request
+ *		with too many arguments or too long a field ends the
+ *		connection rather than being read.
+ *
+ *		Each connection is served by a task on a pool of threads.
+ *		So that a client that stalls cannot hold a worker forever,
+ *		a connection on which nothing can be read or written for
+ *		TIMEOUT seconds is closed.  A request gets a compilation
+ *		context of its own, which is simply thrown away afterwards,
+ *		while the process itself, with its allocator and its
+ *		tables, stays warm.
+ *
+ *		The socket lives in a directory that only its user may
+ *		enter, and each end checks that the other belongs to the
+ *		same user before saying anything, since a server compiles
+ *		whatever it is sent and a client believes whatever it is
+ *		told.
+ */
+
+# include <cerrno>
+# include <csignal>
+# include <cstdint>
+# include <cstdlib>
+# include <cstring>
+# include <iostream>
+# include <sstream>
+# include <exception>
+# include <unistd.h>
+# include <sys/socket.h>
+# include <sys/stat.h>
+# include <sys/time.h>
+# include <sys/un.h>
+# include "CompilationContext.h"
+# include "Source.h"
+# include "ThreadPool.h"
+# include "parser.h"
+# include "server.h"
+
+using namespace std;
+
+static const uint32_t MAXARGS = 1024;
+static const uint32_t MAXARG = 1 << 16;
+static const uint32_t MAXSOURCE = 1 << 30;
+static const time_t TIMEOUT = 30;
+
+
+/*
+ * Function:	socketPath
+ *
+ * Description:	Return the default path of the socket, which is given by
+ *		the environment variable TCC_SOCKET if it is set.
+ *		Otherwise, the socket is in the runtime directory of the
+ *		user if there is one, or else in a directory of its own
+ *		under /tmp, which the server makes private to the user.
+ */
+
+string socketPath()
+{
+    const char *path = getenv("TCC_SOCKET");
+
+
+    if (path != nullptr && *path != '\0')
+	return path;
+
+    path = getenv("XDG_RUNTIME_DIR");
+
+    if (path != nullptr && *path == '/')
+	return string(path) + "/tcc.socket";
+
+    return "/tmp/tcc-" + to_string(getuid()) + "/socket";
+}
+
+
+/*
+ * Function:	prepare (private)
+ *
+ * Description:	Make ready to bind a socket with the given path.  The
+ *		directory of the socket is made if it does not exist, and
+ *		must then either belong to the user and be closed to
+ *		everyone else, or be a shared directory in which only the
+ *		owner of a file may remove it, like /tmp.  Any stale socket
+ *		of the user's is removed, but anything else at the path is
+ *		left alone.  Return whether the path may be bound.
+ */
+
+static bool prepare(const string &path)
+{
+    struct stat info;
+    string directory;
+    size_t slash;
+
+
+    slash = path.rfind('/');
+    directory = slash == string::npos ? "." : path.substr(0, slash + !slash);
+
+    if (mkdir(directory.c_str(), 0700) < 0 && errno != EEXIST) {
+	cerr << directory << ": " << strerror(errno) << endl;
+	return false;
+    }
+
+    if (lstat(directory.c_str(), &info) < 0 || !S_ISDIR(info.st_mode)
+	    || (info.st_uid == getuid() ? (info.st_mode & 077) != 0
+		: (info.st_mode & S_ISVTX) == 0)) {
+	cerr << directory << ": directory is not private" << endl;
+	return false;
+    }
+
+    if (lstat(path.c_str(), &info) < 0)
+	return errno == ENOENT;
+
+    if (!S_ISSOCK(info.st_mode) || info.st_uid != getuid()) {
+	cerr << path << ": not a socket of ours" << endl;
+	return false;
+    }
+
+    return unlink(path.c_str()) == 0;
+}
+
+
+/*
+ * Function:	trusted (private)
+ *
+ * Description:	Return whether the process at the other end of the given
+ *		connection belongs to the same user as we do.
+ */
+
+static bool trusted(int fd)
+{
+    socklen_t length = sizeof(ucred);
+    ucred peer;
+
+
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &length) < 0)
+	return false;
+
+    return peer.uid == getuid();
+}
+
+
+/*
+ * Function:	address (private)
+ *
+ * Description:	Fill in the address of the socket with the given path.
+ *		Return whether the path fits.
+ */
+
+static bool address(const string &path, sockaddr_un &addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(addr.sun_path))
+	return false;
+
+    memcpy(addr.sun_path, path.data(), path.size());
+    return true;
+}
+
+
+/*
+ * Function:	transfer (private)
+ *
+ * Description:	Read or write exactly the given number of bytes,
+ *		retrying after interruptions and short transfers.  Return
+ *		whether every byte was transferred.
+ */
+
+template<class F>
+static bool transfer(F f, int fd, char *data, size_t size)
+{
+    ssize_t n;
+
+
+    while (size > 0) {
+	if ((n = f(fd, data, size)) < 0 && errno == EINTR)
+	    continue;
+
+	if (n <= 0)
+	    return false;
+
+	data += n;
+	size -= n;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function:	sendField (private)
+ *
+ * Description:	Send one field.  Return whether it was sent.
+ */
+
+static bool sendField(int fd, string_view field)
+{
+    uint32_t length = field.size();
+    auto put = [](int fd, char *p, size_t n) { return write(fd, p, n); };
+
+
+    return transfer(put, fd, (char *) &length, sizeof(length))
+	&& transfer(put, fd, (char *) field.data(), field.size());
+}
+
+
+/*
+ * Function:	sendCount (private)
+ *
+ * Description:	Send one integer.  Return whether it was sent.
+ */
+
+static bool sendCount(int fd, uint32_t count)
+{
+    auto put = [](int fd, char *p, size_t n) { return write(fd, p, n); };
+
+
+    return transfer(put, fd, (char *) &count, sizeof(count));
+}
+
+
+/*
+ * Function:	receiveCount (private)
+ *
+ * Description:	Receive one integer.  Return whether it was received.
+ */
+
+static bool receiveCount(int fd, uint32_t &count)
+{
+    auto get = [](int fd, char *p, size_t n) { return read(fd, p, n); };
+
+
+    return transfer(get, fd, (char *) &count, sizeof(count));
+}
+
+
+/*
+ * Function:	receiveField (private)
+ *
+ * Description:	Receive one field of at most the given length.  Return
+ *		whether it was received.
+ */
+
+static bool receiveField(int fd, string &field, uint32_t limit = UINT32_MAX)
+{
+    auto get = [](int fd, char *p, size_t n) { return read(fd, p, n); };
+    uint32_t length;
+
+
+    if (!receiveCount(fd, length) || length > limit)
+	return false;
+
+    field.resize(length);
+    return transfer(get, fd, &field[0], length);
+}
+
+
+/*
+ * Function:	answer (private)
+ *
+ * Description:	Compile the source of one request and build the reply.
+ *		Any operands in the arguments name the files the client
+ *		read, so they are ignored.
+ */
+
+static void answer(const vector<string> &args, string &&text, Reply &reply)
+{
+    ostringstream output, errors;
+    vector<string> operands;
+    Options options;
+    Source source;
+
+
+    if (!options.parse(args, operands)) {
+	reply.status = EXIT_FAILURE;
+	reply.output.clear();
+	reply.errors = "invalid options\n";
+	return;
+    }
+
+    source.open(move(text));
+    CompilationContext context(source, options, output, errors);
+
+    reply.status = compile(context) ? EXIT_SUCCESS : EXIT_FAILURE;
+    reply.output = output.str();
+    reply.errors = errors.str();
+}
+
+
+/*
+ * Function:	session (private)
+ *
+ * Description:	Serve requests on the given connection until the client
+ *		hangs up or sends a request that is too large.
+ */
+
+static void session(int fd)
+{
+    vector<string> args;
+    uint32_t count;
+    string text;
+    Reply reply;
+
+
+    while (receiveCount(fd, count) && count <= MAXARGS) {
+	args.resize(count);
+
+	for (auto &arg : args)
+	    if (!receiveField(fd, arg, MAXARG))
+		return;
+
+	if (!receiveField(fd, text, MAXSOURCE))
+	    return;
+
+	answer(args, move(text), reply);
+
+	if (!sendCount(fd, reply.status) || !sendField(fd, reply.output)
+		|| !sendField(fd, reply.errors))
+	    return;
+    }
+}
+
+
+/*
+ * Function:	serve
+ *
+ * Description:	Listen on the socket with the given path and serve each
+ *		connection from the same user as a task on a pool of the
+ *		given number of threads.  Every read and write on a
+ *		connection times out, which ends the connection.  Anything
+ *		thrown while serving a connection ends only that
+ *		connection, and never the server.  We only return if
+ *		something goes wrong.
+ */
+
+int serve(const string &path, unsigned threads)
+{
+    sockaddr_un addr;
+    timeval timeout;
+    int fd, client;
+
+
+    if (!address(path, addr)) {
+	cerr << path << ": socket path too long" << endl;
+	return EXIT_FAILURE;
+    }
+
+    if (!prepare(path))
+	return EXIT_FAILURE;
+
+    signal(SIGPIPE, SIG_IGN);
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0
+	    || bind(fd, (sockaddr *) &addr, sizeof(addr)) < 0
+	    || listen(fd, SOMAXCONN) < 0) {
+	cerr << path << ": " << strerror(errno) << endl;
+	return EXIT_FAILURE;
+    }
+
+    ThreadPool pool(threads > 0 ? threads : 1);
+
+    while (1) {
+	if ((client = accept(fd, nullptr, nullptr)) < 0) {
+	    if (errno == EINTR || errno == ECONNABORTED)
+		continue;
+
+	    cerr << path << ": " << strerror(errno) << endl;
+	    return EXIT_FAILURE;
+	}
+
+	timeout = {TIMEOUT, 0};
+
+	if (!trusted(client)
+		|| setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+		    sizeof(timeout)) < 0
+		|| setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+		    sizeof(timeout)) < 0) {
+	    close(client);
+	    continue;
+	}
+
+	pool.submit([client]() {
+	    try {
+		session(client);
+	    } catch (const exception &) {
+	    }
+
+	    close(client);
+	});
+    }
+}
+
+
+/*
+ * Function:	connectServer
+ *
+ * Description:	Connect to the server listening on the socket with the
+ *		given path.  Return the connection, or -1 if the server
+ *		could not be reached or belongs to another user.
+ */
+
+int connectServer(const string &path)
+{
+    sockaddr_un addr;
+    int fd;
+
+
+    if (!address(path, addr) || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+	return -1;
+
+    if (connect(fd, (sockaddr *) &addr, sizeof(addr)) < 0 || !trusted(fd)) {
+	close(fd);
+	return -1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    return fd;
+}
+
+
+/*
+ * Function:	request
+ *
+ * Description:	Send a request to compile the given source with the given
+ *		arguments over the given connection, and wait for the
+ *		reply.  Return whether a reply was received.
+ */
+
+bool request(int fd, const vector<string> &args, string_view source,
+    Reply &reply)
+{
+    uint32_t status;
+
+
+    if (!sendCount(fd, args.size()))
+	return false;
+
+    for (const auto &arg : args)
+	if (!sendField(fd, arg))
+	    return false;
+
+    if (!sendField(fd, source) || !receiveCount(fd, status))
+	return false;
+
+    reply.status = status;
+    return receiveField(fd, reply.output) && receiveField(fd, reply.errors);
+}
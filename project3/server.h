@@ -0,0 +1,30 @@
+/*
+ * File:	server.h
+ *
+ * Description:	This file contains the public function declarations for
+ *		the compile server for Tiny C.  A server listens on a Unix
+ *		domain socket and compiles whatever sources its clients
+ *		send it, so that a build issuing many small compilations
+ *		pays for starting a process only once.
+ */
+
+# ifndef SERVER_H
+# define SERVER_H
+# include <string>
+# include <string_view>
+# include <vector>
+
+struct Reply {
+    int status;
+    std::string output, errors;
+};
+
+std::string socketPath();
+
+int serve(const std::string &path, unsigned threads);
+
+int connectServer(const std::string &path);
+bool request(int fd, const std::vector<std::string> &args,
+    std::string_view source, Reply &reply);
+
+# endif /* SERVER_H */
@@ -0,0 +1,340 @@
+/*
+ * File:	simd.cpp
+ *
+ * Description:	This file contains the function definitions for the
+ *		block-scanning primitives used by the lexical analyzer.
+ *
+ *		SSE2 is part of the x86-64 baseline, so those versions are
+ *		always compiled in there.  The AVX2 versions are compiled
+ *		with a target attribute and selected at run time only if
+ *		the processor supports them, so the same binary runs
+ *		everywhere.
+ */
+
+# include "simd.h"
+
+# if defined(__SSE2__)
+# include <immintrin.h>
+# define HAVE_SSE2 1
+# endif
+
+# if defined(HAVE_SSE2) && defined(__GNUC__)
+# define HAVE_AVX2 1
+# endif
+
+
+/*
+ * Function:	isSpace (private)
+ *
+ * Description:	Return whether the given character is white space, which
+ *		in Tiny C is a blank, form feed, newline, carriage return,
+ *		horizontal tab, or vertical tab.
+ */
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || (unsigned char) (c - '\t') <= '\r' - '\t';
+}
+
+
+# ifdef HAVE_SSE2
+
+/*
+ * Function:	spaceMask (private)
+ *
+ * Description:	Return a byte mask of the white space characters in the
+ *		given block.  The control characters \t through \r are
+ *		contiguous, so a saturating subtraction reduces the range
+ *		check to a comparison with zero.
+ */
+
+static inline __m128i spaceMask(__m128i v)
+{
+    __m128i blank, ctrl;
+
+
+    blank = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    ctrl = _mm_subs_epu8(_mm_sub_epi8(v, _mm_set1_epi8('\t')),
+	    _mm_set1_epi8('\r' - '\t'));
+    ctrl = _mm_cmpeq_epi8(ctrl, _mm_setzero_si128());
+
+    return _mm_or_si128(blank, ctrl);
+}
+
+# endif /* HAVE_SSE2 */
+
+
+# ifdef HAVE_AVX2
+
+/*
+ * Function:	hasAVX2 (private)
+ *
+ * Description:	Return whether the processor we are running on supports
+ *		AVX2.  The answer is computed once.
+ */
+
+static bool hasAVX2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+
+/*
+ * Function:	skipCommentAVX2 (private)
+ *
+ * Description:	The AVX2 version of the block loop of skipComment.  We
+ *		return the position of the first "*" that is followed by a
+ *		"/", or the position at which fewer than thirty-three bytes
+ *		remain if there is no such position before then.
+ */
+
+__attribute__((target("avx2")))
+static const char *skipCommentAVX2(const char *p, const char *end,
+	bool &found)
+{
+    __m256i star, slash, v, w;
+    unsigned mask;
+
+
+    star = _mm256_set1_epi8('*');
+    slash = _mm256_set1_epi8('/');
+    found = false;
+
+    while (end - p > 32) {
+	v = _mm256_loadu_si256((const __m256i *) p);
+	w = _mm256_loadu_si256((const __m256i *) (p + 1));
+	mask = _mm256_movemask_epi8(_mm256_and_si256(
+		_mm256_cmpeq_epi8(v, star), _mm256_cmpeq_epi8(w, slash)));
+
+	if (mask != 0) {
+	    found = true;
+	    return p + __builtin_ctz(mask);
+	}
+
+	p += 32;
+    }
+
+    return p;
+}
+
+
+/*
+ * Function:	countNewlinesAVX2 (private)
+ *
+ * Description:	The AVX2 version of the block loop of countNewlines.  We
+ *		advance the given pointer past the blocks we count.
+ */
+
+__attribute__((target("avx2")))
+static size_t countNewlinesAVX2(const char *&p, const char *end)
+{
+    __m256i newline, v;
+    size_t count;
+
+
+    newline = _mm256_set1_epi8('\n');
+    count = 0;
+
+    while (end - p >= 32) {
+	v = _mm256_loadu_si256((const __m256i *) p);
+	count += __builtin_popcount(
+		_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline)));
+	p += 32;
+    }
+
+    return count;
+}
+
+# endif /* HAVE_AVX2 */
+
+
+/*
+ * Function:	skipSpace
+ *
+ * Description:	Return a pointer to the first character at or after p
+ *		that is not white space, or end if there is none.  Runs
+ *		of white space in source code are short, so we only ever
+ *		use sixteen-byte blocks here.
+ */
+
+const char *skipSpace(const char *p, const char *end)
+{
+# ifdef HAVE_SSE2
+    __m128i v;
+    unsigned mask;
+
+
+    while (end - p >= 16) {
+	v = _mm_loadu_si128((const __m128i *) p);
+	mask = ~_mm_movemask_epi8(spaceMask(v)) & 0xffff;
+
+	if (mask != 0)
+	    return p + __builtin_ctz(mask);
+
+	p += 16;
+    }
+# endif
+
+    while (p < end && isSpace(*p))
+	p ++;
+
+    return p;
+}
+
+
+/*
+ * Function:	skipComment
+ *
+ * Description:	Given a pointer just past the opening delimiter of a
+ *		comment, return a pointer just past its closing delimiter,
+ *		or a null pointer if the comment is not terminated.
+ */
+
+const char *skipComment(const char *p, const char *end)
+{
+# ifdef HAVE_AVX2
+    bool found;
+
+
+    if (hasAVX2()) {
+	p = skipCommentAVX2(p, end, found);
+
+	if (found)
+	    return p + 2;
+    }
+# endif
+
+# ifdef HAVE_SSE2
+    __m128i v, w;
+    unsigned mask;
+
+
+    while (end - p > 16) {
+	v = _mm_loadu_si128((const __m128i *) p);
+	w = _mm_loadu_si128((const __m128i *) (p + 1));
+	mask = _mm_movemask_epi8(_mm_and_si128(
+		_mm_cmpeq_epi8(v, _mm_set1_epi8('*')),
+		_mm_cmpeq_epi8(w, _mm_set1_epi8('/'))));
+
+	if (mask != 0)
+	    return p + __builtin_ctz(mask) + 2;
+
+	p += 16;
+    }
+# endif
+
+    while (end - p >= 2) {
+	if (p[0] == '*' && p[1] == '/')
+	    return p + 2;
+
+	p ++;
+    }
+
+    return nullptr;
+}
+
+
+/*
+ * Function:	findBackslash
+ *
+ * Description:	Return a pointer to the first backslash at or after p, or
+ *		end if there is none.
+ */
+
+const char *findBackslash(const char *p, const char *end)
+{
+# ifdef HAVE_SSE2
+    __m128i v;
+    unsigned mask;
+
+
+    while (end - p >= 16) {
+	v = _mm_loadu_si128((const __m128i *) p);
+	mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+
+	if (mask != 0)
+	    return p + __builtin_ctz(mask);
+
+	p += 16;
+    }
+# endif
+
+    while (p < end && *p != '\\')
+	p ++;
+
+    return p;
+}
+
+
+/*
+ * Function:	findUnprintable
+ *
+ * Description:	Return a pointer to the first unprintable character at or
+ *		after p, or end if there is none.  In the C locale, only
+ *		the characters from blank through tilde are printable.
+ *		Compared as signed bytes, everything else is either less
+ *		than a blank or exactly DEL.
+ */
+
+const char *findUnprintable(const char *p, const char *end)
+{
+# ifdef HAVE_SSE2
+    __m128i v;
+    unsigned mask;
+
+
+    while (end - p >= 16) {
+	v = _mm_loadu_si128((const __m128i *) p);
+	mask = _mm_movemask_epi8(_mm_or_si128(
+		_mm_cmplt_epi8(v, _mm_set1_epi8(' ')),
+		_mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f))));
+
+	if (mask != 0)
+	    return p + __builtin_ctz(mask);
+
+	p += 16;
+    }
+# endif
+
+    while (p < end && (unsigned char) (*p - ' ') < 0x7f - ' ')
+	p ++;
+
+    return p;
+}
+
+
+/*
+ * Function:	countNewlines
+ *
+ * Description:	Return the number of newlines between p and end.
+ */
+
+size_t countNewlines(const char *p, const char *end)
+{
+    size_t count = 0;
+
+
+# ifdef HAVE_AVX2
+    if (hasAVX2())
+	count += countNewlinesAVX2(p, end);
+# endif
+
+# ifdef HAVE_SSE2
+    __m128i v;
+
+
+    while (end - p >= 16) {
+	v = _mm_loadu_si128((const __m128i *) p);
+	count += __builtin_popcount(
+		_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+	p += 16;
+    }
+# endif
+
+    while (p < end)
+	if (*p ++ == '\n')
+	    count ++;
+
+    return count;
+}
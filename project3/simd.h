@@ -0,0 +1,25 @@
+/*
+ * File:	simd.h
+ *
+ * Description:	This file contains the function declarations for the
+ *		block-scanning primitives used by the lexical analyzer
+ *		and for locating positions in the source.  Each function
+ *		examines sixteen or thirty-two bytes at a time using SSE2
+ *		or AVX2 when the machine has them, and falls back to a
+ *		simple byte loop otherwise.  None of them ever reads at or
+ *		beyond the given end pointer.
+ */
+
+# ifndef SIMD_H
+# define SIMD_H
+# include <cstddef>
+
+const char *skipSpace(const char *p, const char *end);
+const char *skipComment(const char *p, const char *end);
+
+const char *findBackslash(const char *p, const char *end);
+const char *findUnprintable(const char *p, const char *end);
+
+size_t countNewlines(const char *p, const char *end);
+
+# endif /* SIMD_H */
@@ -2,119 +2,170 @@
  * File:	string.cpp
  *
  * Description:	This file contains the function definitions for parsing and
- *		escaping C-style escape sequences in strings.
+ *		escaping C-style escape sequences in strings, and for
+ *		quoting strings for JSON.
+ *
+ *		Most of any string is ordinary characters that are simply
+ *		copied.  So, rather than looking at one character at a
+ *		time, we search for the next character of interest a
+ *		block at a time and copy everything before it in bulk.
  */
 
 # include <climits>
+# include <cstring>
 # include "string.h"
+# include "simd.h"
 
 using namespace std;
 
 
+/*
+ * Function:	at (private)
+ *
+ * Description:	Return the character at the given index in the string, or
+ *		a null character if the index is past the end.  Unlike a
+ *		string, a view has no terminating null character.
+ */
+
+static inline char at(string_view s, unsigned i)
+{
+    return i < s.size() ? s[i] : '\0';
+}
+
+
 /*
  * Function:	parseString
  *
- * Description:	Parse a string contains C-style escape sequences.  An
- *		invalid escape sequence is detected, as is an overflow in
- *		an octal or hexadecimal escape sequence.
+ * Description:	Parse a string contains C-style escape sequences into the
+ *		given buffer, which must be at least as long as the
+ *		string, and return the length of the result.  An invalid
+ *		escape sequence is detected, as is an overflow in an octal
+ *		or hexadecimal escape sequence.
  */
 
-string parseString(const string &s, bool &invalid, bool &overflow)
+size_t parseString(string_view s, char *result, bool &invalid,
+	bool &overflow)
 {
-    unsigned start, val;
-    string result;
+    unsigned i, start, val;
+    size_t n = 0, run;
 
 
     invalid = false;
     overflow = false;
+    i = 0;
 
-    for (unsigned i = 0; i < s.size(); i ++) {
-	if (s[i] == '\\') {
-	    i ++;
+    while (i < s.size()) {
+	if (s[i] != '\\') {
+	    run = findBackslash(s.data() + i, s.data() + s.size()) - s.data();
+	    memcpy(result + n, s.data() + i, run - i);
+	    n += run - i;
+	    i = run;
 
-	    switch(s[i]) {
-	    case 'a':
-		result += '\a';
-		break;
-
-	    case 'b':
-		result += '\b';
-		break;
-
-	    case 'f':
-		result += '\f';
+	    if (i == s.size())
 		break;
+	}
+
+	i ++;
+
+	switch(at(s, i)) {
+	case 'a':
+	    result[n ++] = '\a';
+	    break;
+
+	case 'b':
+	    result[n ++] = '\b';
+	    break;
+
+	case 'f':
+	    result[n ++] = '\f';
+	    break;
+
+	case 'n':
+	    result[n ++] = '\n';
+	    break;
+
+	case 'r':
+	    result[n ++] = '\r';
+	    break;
+
+	case 't':
+	    result[n ++] = '\t';
+	    break;
+
+	case 'v':
+	    result[n ++] = '\v';
+	    break;
+
+	case '\\': case '\?': case '\'': case '\"':
+	    result[n ++] = s[i];
+	    break;
+
+	case 'x':
+	    val = 0;
+	    start = i;
+
+	    while (1) {
+		if (at(s, i + 1) >= '0' && at(s, i + 1) <= '9')
+		    val = val * 16 + (s[++ i] - '0');
+		else if (at(s, i + 1) >= 'a' && at(s, i + 1) <= 'f')
+		    val = val * 16 + (s[++ i] - 'a' + 10);
+		else if (at(s, i + 1) >= 'A' && at(s, i + 1) <= 'F')
+		    val = val * 16 + (s[++ i] - 'A' + 10);
+		else
+		    break;
+	    }
 
-	    case 'n':
-		result += '\n';
-		break;
+	    if (start == i) {
+		invalid = true;
+		val = 'x';
+	    } else if (val > UCHAR_MAX)
+		overflow = true;
 
-	    case 'r':
-		result += '\r';
-		break;
+	    result[n ++] = val;
+	    break;
 
-	    case 't':
-		result += '\t';
-		break;
+	case '0': case '1': case '2': case '3':
+	case '4': case '5': case '6': case '7':
+	    val = s[i] - '0';
 
-	    case 'v':
-		result += '\v';
-		break;
+	    if (at(s, i + 1) >= '0' && at(s, i + 1) <= '7')
+		val = val * 8 + (s[++ i] - '0');
 
-	    case '\\': case '\?': case '\'': case '\"':
-		result += s[i];
-		break;
+	    if (at(s, i + 1) >= '0' && at(s, i + 1) <= '7')
+		val = val * 8 + (s[++ i] - '0');
 
-	    case 'x':
-		val = 0;
-		start = i;
-
-		while (1) {
-		    if (s[i + 1] >= '0' && s[i + 1] <= '9')
-			val = val * 16 + (s[++ i] - '0');
-		    else if (s[i + 1] >= 'a' && s[i + 1] <= 'f')
-			val = val * 16 + (s[++ i] - 'a' + 10);
-		    else if (s[i + 1] >= 'A' && s[i + 1] <= 'F')
-			val = val * 16 + (s[++ i] - 'A' + 10);
-		    else
-			break;
-		}
-
-		if (start == i) {
-		    invalid = true;
-		    val = 'x';
-		} else if (val > UCHAR_MAX)
-		    overflow = true;
-
-		result += val;
-		break;
+	    if (val > UCHAR_MAX)
+		overflow = true;
 
-	    case '0': case '1': case '2': case '3':
-	    case '4': case '5': case '6': case '7':
-		val = s[i] - '0';
+	    result[n ++] = val;
+	    break;
 
-		if (s[i + 1] >= '0' && s[i + 1] <= '7')
-		    val = val * 8 + (s[++ i] - '0');
+	default:
+	    invalid = true;
+	    result[n ++] = at(s, i);
+	    break;
+	}
 
-		if (s[i + 1] >= '0' && s[i + 1] <= '7')
-		    val = val * 8 + (s[++ i] - '0');
+	i ++;
+    }
 
-		if (val > UCHAR_MAX)
-		    overflow = true;
+    return n;
+}
 
-		result += val;
-		break;
 
-	    default:
-		invalid = true;
-		result += s[i];
-		break;
-	    }
+/*
+ * Function:	parseString
+ *
+ * Description:	Parse a string contains C-style escape sequences.  An
+ *		invalid escape sequence is detected, as is an overflow in
+ *		an octal or hexadecimal escape sequence.
+ */
 
-	} else
-	    result += s[i];
-    }
+string parseString(string_view s, bool &invalid, bool &overflow)
+{
+    string result(s.size(), '\0');
 
+    result.resize(parseString(s, &result[0], invalid, overflow));
     return result;
 }
 
@@ -126,7 +177,7 @@ string parseString(const string &s, bool &invalid, bool &overflow)
  *		invalid escape sequence is silently ignored.
  */
 
-string parseString(const string &s)
+string parseString(string_view s)
 {
     bool invalid, overflow;
     return parseString(s, invalid, overflow);
@@ -137,21 +188,125 @@ string parseString(const string &s)
  * Function:	escapeString
  *
  * Description:	Return a copy of the given string but with any unprintable
- *		character replaced with an octal escape sequence.
+ *		character replaced with an octal escape sequence.  We
+ *		reserve room for the common case of few such characters.
  */
 
-string escapeString(const string &s)
+string escapeString(string_view s)
 {
-    char buf[5];
+    const char *p, *q, *end;
+    unsigned char c;
+    char buf[4], *digits;
     string result;
 
 
-    for (unsigned i = 0; i < s.size(); i ++)
-	if (!isprint(s[i])) {
-	    sprintf(buf, "\\%o", (unsigned char) s[i]);
-	    result += buf;
+    result.reserve(s.size() + 8);
+    end = s.data() + s.size();
+
+    for (p = s.data(); p < end; p = q + 1) {
+	q = findUnprintable(p, end);
+	result.append(p, q - p);
+
+	if (q == end)
+	    break;
+
+	c = *q;
+	digits = buf + sizeof(buf);
+
+	do {
+	    *-- digits = '0' + c % 8;
+	    c /= 8;
+	} while (c != 0);
+
+	*-- digits = '\\';
+	result.append(digits, buf + sizeof(buf) - digits);
+    }
+
+    return result;
+}
+
+
+/*
+ * Function:	sequence (private)
+ *
+ * Description:	Return the length of the well-formed UTF-8 sequence at the
+ *		start of the given string, or zero if there is none there.
+ *		Overlong forms, surrogates, and code points beyond U+10FFFF
+ *		are not well-formed.
+ */
+
+static size_t sequence(string_view s)
+{
+    unsigned char c = s[0], low = 0x80, high = 0xbf;
+    size_t length;
+
+
+    if (c >= 0xc2 && c <= 0xdf)
+	length = 2;
+    else if (c >= 0xe0 && c <= 0xef) {
+	length = 3;
+	low = c == 0xe0 ? 0xa0 : low;
+	high = c == 0xed ? 0x9f : high;
+    } else if (c >= 0xf0 && c <= 0xf4) {
+	length = 4;
+	low = c == 0xf0 ? 0x90 : low;
+	high = c == 0xf4 ? 0x8f : high;
+    } else
+	return 0;
+
+    if (s.size() < length || (unsigned char) s[1] < low
+	    || (unsigned char) s[1] > high)
+	return 0;
+
+    for (size_t i = 2; i < length; i ++)
+	if ((unsigned char) s[i] < 0x80 || (unsigned char) s[i] > 0xbf)
+	    return 0;
+
+    return length;
+}
+
+
+/*
+ * Function:	quoteJSON
+ *
+ * Description:	Return the given string as a JSON string, in double quotes
+ *		and with any quote, backslash, or control character
+ *		escaped.  A source need not be UTF-8, so any byte that is
+ *		not part of a well-formed UTF-8 sequence is escaped as the
+ *		Latin-1 character with the same value, which keeps the
+ *		result valid JSON.  These are only ever short strings,
+ *		such as diagnostics, so we simply look at one character at
+ *		a time.
+ */
+
+string quoteJSON(string_view s)
+{
+    static const char hex[] = "0123456789abcdef";
+    unsigned char c;
+    string result;
+    size_t length;
+
+
+    result.reserve(s.size() + 2);
+    result += '"';
+
+    for (size_t i = 0; i < s.size(); i ++) {
+	c = s[i];
+
+	if (c == '"' || c == '\\') {
+	    result += '\\';
+	    result += c;
+	} else if (c >= 0x80 && (length = sequence(s.substr(i))) > 0) {
+	    result.append(s, i, length);
+	    i += length - 1;
+	} else if (c < ' ' || c >= 0x80) {
+	    result += "\\u00";
+	    result += hex[c / 16];
+	    result += hex[c % 16];
 	} else
-	    result += s[i];
+	    result += c;
+    }
 
+    result += '"';
     return result;
 }
@@ -2,15 +2,20 @@
  * File:	string.h
  *
  * Description:	This file contains the function declarations for parsing
- *		and escaping C-style escape sequences in strings.
+ *		and escaping C-style escape sequences in strings, and for
+ *		quoting strings for JSON.
  */
 
 # ifndef STRING_H
 # define STRING_H
 # include <string>
+# include <string_view>
 
-std::string parseString(const std::string &s);
-std::string parseString(const std::string &s, bool &invalid, bool &overflow);
-std::string escapeString(const std::string &s);
+std::string parseString(std::string_view s);
+std::string parseString(std::string_view s, bool &invalid, bool &overflow);
+size_t parseString(std::string_view s, char *result, bool &invalid,
+	bool &overflow);
+std::string escapeString(std::string_view s);
+std::string quoteJSON(std::string_view s);
 
 # endif /* STRING_H */
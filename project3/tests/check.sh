@@ -0,0 +1,43 @@
+#!/bin/sh
+#
+# File:		check.sh
+#
+# Description:	Check that parsing lazily or in parallel changes nothing
+#		about a compilation.  Each test is compiled at once, with
+#		-flazy, and with -j, and the output and diagnostics of each
+#		must match those of the first exactly.  Every test is run
+#		both with the default error limit and with none, so that
+#		recovery from syntax errors is checked as well.  Every
+#		function in a test is reachable from main, so that parsing
+#		lazily skips none of them.
+#
+# Usage:	check.sh tcc test.c ...
+#
+
+tcc=$1
+shift
+
+out=/tmp/check.$$
+trap 'rm -f $out.*' 0
+status=0
+
+for test in "$@"; do
+    for limit in "" -ferror-limit=0; do
+	"$tcc" $limit "$test" > $out.output 2> $out.errors
+
+	for flags in -flazy "-j 2"; do
+	    "$tcc" $limit $flags "$test" > $out.output2 2> $out.errors2
+
+	    if ! cmp -s $out.output $out.output2 ||
+		! cmp -s $out.errors $out.errors2
+	    then
+		echo "$test: $limit $flags differs:"
+		diff $out.errors $out.errors2
+		diff $out.output $out.output2
+		status=1
+	    fi
+	done
+    done
+done
+
+exit $status
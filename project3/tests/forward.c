@@ -0,0 +1,37 @@
+/*
+ * A function body sees only the global declarations that precede it,
+ * so the uses below of names declared later are errors, even when the
+ * body is parsed later, as it is with -flazy or -j.
+ */
+
+int f(int n)
+{
+    int a;
+
+    x = n;				/* 'x' undeclared */
+    g(n);
+    a = h(n);
+    return a + y[0];			/* 'y' undeclared */
+}
+
+int x, y[10];
+
+int g(int a, int b)			/* 'g' redeclared */
+{
+    return f(a + b);
+}
+
+int h(int n)				/* 'h' redeclared */
+{
+    return x + y[n];
+}
+
+int k(int n)
+{
+    return h(n) + g(n, n);
+}
+
+int main(void)
+{
+    return f(1) + k(2);
+}
@@ -0,0 +1,14 @@
+/*
+ * A syntax error hides the first use of a name from the scan that
+ * pre-declares the functions a body calls, so with -flazy the calls
+ * after it must find the implicit declaration made by the first of
+ * them rather than declare the function again.
+ */
+
+int main(void)
+{
+    f + ;				/* syntax error at '+' */
+    f();
+    f();
+    return f();
+}
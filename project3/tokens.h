@@ -5,12 +5,18 @@
  *		lexical analyzer and parser for Tiny C.  Single character
  *		tokens use their ASCII values, so we can refer to them
  *		either as character literals or as symbolic names.
+ *
+ *		Everything we know about a token is kept in a single table
+ *		that is built at compile time and indexed directly by the
+ *		token value.  Each entry holds the lexeme of the token, its
+ *		precedence and arity as an operator in an expression, and
+ *		whether it is a keyword.  The lexeme is also how the token
+ *		is written when printing the AST, which is why some tokens
+ *		that never appear in the source have one.
  */
 
 # ifndef TOKENS_H
 # define TOKENS_H
-# include <string>
-# include <unordered_map>
 
 enum {
     ASSIGN = '=', LTN = '<', GTN = '>', PLUS = '+', MINUS = '-',
@@ -24,9 +30,135 @@ enum {
     UNION, UNSIGNED, VOID, VOLATILE, WHILE,
 
     OR, AND, EQL, NEQ, LEQ, GEQ, INC, DEC, NEGATE, INDEX, FUNC, PROC, BLOCK,
-    LOCAL, GLOBAL, TEMP, NAME, NUM, STRLIT, CHARLIT, DONE = 0, ERROR = -1
+    LOCAL, GLOBAL, TEMP, NAME, NUM, STRLIT, CHARLIT, DONE = 0, ERROR = -1,
+    NTOKENS = CHARLIT + 1
+};
+
+enum {
+    UNARY = 1, BINARY = 2
+};
+
+enum {
+    NO_PRECEDENCE, LOGICAL_OR, LOGICAL_AND, EQUALITY, RELATIONAL, ADDITIVE,
+    MULTIPLICATIVE
+};
+
+struct TokenInfo {
+    const char *lexeme;
+    unsigned char length, precedence, arity;
+    bool keyword;
+};
+
+struct TokenTable {
+    TokenInfo entries[NTOKENS - ERROR];
+
+    constexpr const TokenInfo &operator [](int token) const {
+	return entries[token - ERROR];
+    }
+
+    constexpr TokenInfo &operator [](int token) {
+	return entries[token - ERROR];
+    }
 };
 
-extern std::unordered_map<int, std::string> lexemes;
+
+/*
+ * Function:	makeTokenTable
+ *
+ * Description:	Build the token table.  Any token not listed has an empty
+ *		lexeme and is neither a keyword nor an operator.
+ */
+
+constexpr TokenTable makeTokenTable()
+{
+    TokenTable table = {};
+
+
+    for (int token = ERROR; token < NTOKENS; token ++)
+	table[token] = {"", 0, NO_PRECEDENCE, 0, false};
+
+    auto add = [&table](int token, const char *lexeme, unsigned precedence,
+	    unsigned arity, bool keyword) {
+	unsigned length = 0;
+
+	while (lexeme[length] != '\0')
+	    length ++;
+
+	table[token] = {lexeme, (unsigned char) length,
+	    (unsigned char) precedence, (unsigned char) arity, keyword};
+    };
+
+    auto keyword = [&add](int token, const char *lexeme) {
+	add(token, lexeme, NO_PRECEDENCE, 0, true);
+    };
+
+    auto binary = [&add](int token, const char *lexeme, unsigned precedence) {
+	add(token, lexeme, precedence, BINARY, false);
+    };
+
+    auto unary = [&add](int token, const char *lexeme) {
+	add(token, lexeme, NO_PRECEDENCE, UNARY, false);
+    };
+
+    keyword(AUTO, "auto");
+    keyword(BREAK, "break");
+    keyword(CASE, "case");
+    keyword(CHAR, "char");
+    keyword(CONST, "const");
+    keyword(CONTINUE, "continue");
+    keyword(DEFAULT, "default");
+    keyword(DO, "do");
+    keyword(DOUBLE, "double");
+    keyword(ELSE, "else");
+    keyword(ENUM, "enum");
+    keyword(EXTERN, "extern");
+    keyword(FLOAT, "float");
+    keyword(FOR, "for");
+    keyword(GOTO, "goto");
+    keyword(IF, "if");
+    keyword(INT, "int");
+    keyword(LONG, "long");
+    keyword(REGISTER, "register");
+    keyword(RETURN, "return");
+    keyword(SHORT, "short");
+    keyword(SIGNED, "signed");
+    keyword(SIZEOF, "sizeof");
+    keyword(STATIC, "static");
+    keyword(STRUCT, "struct");
+    keyword(SWITCH, "switch");
+    keyword(TYPEDEF, "typedef");
+    keyword(UNION, "union");
+    keyword(UNSIGNED, "unsigned");
+    keyword(VOID, "void");
+    keyword(VOLATILE, "volatile");
+    keyword(WHILE, "while");
+
+    binary(OR, "||", LOGICAL_OR);
+    binary(AND, "&&", LOGICAL_AND);
+    binary(EQL, "==", EQUALITY);
+    binary(NEQ, "!=", EQUALITY);
+    binary('<', "<", RELATIONAL);
+    binary('>', ">", RELATIONAL);
+    binary(LEQ, "<=", RELATIONAL);
+    binary(GEQ, ">=", RELATIONAL);
+    binary('+', "+", ADDITIVE);
+    binary('-', "-", ADDITIVE);
+    binary('*', "*", MULTIPLICATIVE);
+    binary('/', "/", MULTIPLICATIVE);
+    binary('%', "%", MULTIPLICATIVE);
+
+    unary('!', "!");
+    unary(NEGATE, "-");
+
+    add('=', "=", NO_PRECEDENCE, BINARY, false);
+    add(INDEX, "index", NO_PRECEDENCE, BINARY, false);
+    add(FUNC, "call", NO_PRECEDENCE, 0, false);
+    add(PROC, "call", NO_PRECEDENCE, 0, false);
+    add(BLOCK, "begin", NO_PRECEDENCE, 0, false);
+
+    return table;
+}
+
+inline constexpr TokenTable tokenTable = makeTokenTable();
 
 # endif /* TOKENS_H */